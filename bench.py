@@ -0,0 +1,171 @@
+import argparse, csv, json, re, subprocess, sys, tempfile, time
+from pathlib import Path
+
+# benchmark driver for bin/fp
+#   python3 bench.py run [--strategies a,b] [--encodings a,b] [--budget s] [--out results.json|.csv]
+#   python3 bench.py compare base.json new.json [--height-tol f] [--time-tol f] [--memory-tol f]
+
+FIELDS = ["instance", "strategy", "encoding", "status", "valid", "height", "lower_bound", "gap",
+          "utilization", "wall_s", "peak_rss_kb"]
+
+# strategies that build an ILP, only these are run once per --formulation encoding
+ILP_STRATEGIES = {"ilp", "lns", "bisect", "augment", "cluster", "portfolio"}
+
+def read_instance(path: Path):
+    lines = path.read_text(encoding="utf-8", errors="ignore").split()
+    n = int(lines[1])
+    nums = [int(t) for t in lines[2:] if re.match(r"^-?\d+$", t)]
+    area = sum(nums[3 * i + 1] * nums[3 * i + 2] for i in range(n))
+    return n, area
+
+def read_spec(path: Path):
+    vals = [float(t) for t in path.read_text().split()]
+    # problem type, then target width and height
+    return vals[1], vals[2]
+
+def run_one(binary: Path, inp: Path, spec: Path, strategy: str, encoding: str, budget: float, extra):
+    n, area = read_instance(inp)
+    width, _ = read_spec(spec)
+    row = {"instance": inp.stem, "strategy": strategy, "encoding": encoding, "status": "ok", "valid": False,
+           "height": None, "lower_bound": None, "gap": None, "utilization": None,
+           "wall_s": None, "peak_rss_kb": None}
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out = Path(tmp) / "out.txt"; prof = Path(tmp) / "profile.json"
+        cmd = [str(binary), str(inp), str(spec), str(out), "--strategy", strategy,
+               "--formulation", encoding, "--profile", str(prof), "--log-file", "", "--log-console", "0"]
+        if budget > 0:
+            cmd += ["--time-budget", str(budget)]
+        cmd += extra
+
+        start = time.monotonic()
+        try:
+            proc = subprocess.run(cmd, capture_output=True, text=True,
+                                  timeout=budget * 2 + 30 if budget > 0 else None)
+        except subprocess.TimeoutExpired:
+            row["status"] = "timeout"; row["wall_s"] = time.monotonic() - start
+            return row
+        row["wall_s"] = time.monotonic() - start
+        if proc.returncode != 0:
+            row["status"] = f"exit {proc.returncode}"
+
+        text = proc.stdout
+        # portfolio workers print their own summary first, the last one is the final result
+        found = re.findall(r"Height (\d+), lower bound (\d+), gap ([\d.eE+-]+)%", text)
+        if found:
+            h, lb, gap = found[-1]
+            row["height"] = int(h); row["lower_bound"] = int(lb)
+            row["gap"] = round(float(gap) / 100.0, 6)
+        m = re.search(r"The height of the floorplan is (\d+)", text)
+        if m:
+            row["height"] = int(m.group(1))
+        row["valid"] = m is not None and "overlap!" not in text and "exceed the boundary" not in text
+        if row["height"]:
+            row["utilization"] = area / (width * row["height"])
+
+        # the watchdog path also writes the profile, a killed run has none
+        if prof.exists():
+            row["peak_rss_kb"] = json.loads(prof.read_text()).get("peak_rss_kb")
+    return row
+
+def write_results(rows, path: Path):
+    if path.suffix == ".csv":
+        with path.open("w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=FIELDS); w.writeheader(); w.writerows(rows)
+    else:
+        path.write_text(json.dumps(rows, indent=2) + "\n")
+
+def read_results(path: Path):
+    if path.suffix != ".csv":
+        return json.loads(path.read_text())
+    rows = []
+    with path.open() as f:
+        for r in csv.DictReader(f):
+            for k in ("height", "lower_bound", "peak_rss_kb"):
+                r[k] = int(r[k]) if r[k] else None
+            for k in ("gap", "utilization", "wall_s"):
+                r[k] = float(r[k]) if r[k] else None
+            r["valid"] = r["valid"] == "True"
+            rows.append(r)
+    return rows
+
+def runs(args):
+    encodings = args.encodings.split(",")
+    for strategy in args.strategies.split(","):
+        for encoding in encodings if strategy in ILP_STRATEGIES else encodings[:1]:
+            yield strategy, encoding
+
+def cmd_run(args):
+    root = Path(__file__).resolve().parent
+    binary = Path(args.binary)
+    inputs = sorted((root / "input").glob("*.in")) if not args.instances else \
+             [root / "input" / f"{s}.in" for s in args.instances.split(",")]
+    rows = []
+    for inp in inputs:
+        spec = root / "spec" / f"{inp.stem}.spec"
+        if not spec.exists():
+            print(f"[skip] {inp.name}: no {spec.name}", file=sys.stderr); continue
+        for strategy, encoding in runs(args):
+            row = run_one(binary, inp, spec, strategy, encoding, args.budget, args.extra)
+            rows.append(row)
+            print(f"{row['instance']:>8} {strategy:>10} {encoding:>9}  {row['status']:>8}  height {row['height']}  "
+                  f"gap {row['gap']}  util {row['utilization'] and round(row['utilization'], 4)}  "
+                  f"{row['wall_s']:.2f}s  {row['peak_rss_kb']} KB" + ("" if row["valid"] else "  INVALID"))
+    write_results(rows, Path(args.out))
+    print(f"Wrote {len(rows)} results to {args.out}")
+
+def cmd_compare(args):
+    # results from before the encoding sweep were all bigm
+    ident = lambda r: (r["instance"], r["strategy"], r.get("encoding") or "bigm")
+    base = {ident(r): r for r in read_results(Path(args.base))}
+    new = {ident(r): r for r in read_results(Path(args.new))}
+    regressions = 0
+
+    def worse(a, b, tol, slack=0.0):
+        # relative increase beyond tol and beyond an absolute slack, missing values never count
+        return a is not None and b is not None and b > a * (1 + tol) + slack + 1e-9
+
+    for key in sorted(base.keys() & new.keys()):
+        a, b = base[key], new[key]; notes = []
+        if a["valid"] and not b["valid"]:
+            notes.append("became invalid")
+        if worse(a["height"], b["height"], args.height_tol):
+            notes.append(f"height {a['height']} -> {b['height']}")
+        if worse(a["wall_s"], b["wall_s"], args.time_tol, args.time_slack):
+            notes.append(f"time {a['wall_s']:.2f}s -> {b['wall_s']:.2f}s")
+        if worse(a["peak_rss_kb"], b["peak_rss_kb"], args.memory_tol):
+            notes.append(f"memory {a['peak_rss_kb']} -> {b['peak_rss_kb']} KB")
+        status = "REGRESSION " + ", ".join(notes) if notes else "ok"
+        regressions += bool(notes)
+        print(f"{key[0]:>8} {key[1]:>10} {key[2]:>9}  {status}")
+
+    for key in sorted(base.keys() - new.keys()):
+        print(f"{key[0]:>8} {key[1]:>10} {key[2]:>9}  missing from {args.new}")
+    print(f"{regressions} regression(s)")
+    return 1 if regressions else 0
+
+def main():
+    ap = argparse.ArgumentParser(description="Run or compare floorplanner benchmarks")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    r = sub.add_parser("run", help="run every input/*.in with its spec/*.spec")
+    r.add_argument("--binary", default="bin/fp")
+    r.add_argument("--strategies", default="shelf,skyline,tempering,ilp")
+    r.add_argument("--encodings", default="bigm,indicator", help="--formulation values swept for ILP strategies")
+    r.add_argument("--instances", default="", help="comma separated names, default all of input/")
+    r.add_argument("--budget", type=float, default=60.0, help="--time-budget per run, 0 for none")
+    r.add_argument("--out", default="bench_results.json", help=".json or .csv")
+    r.add_argument("extra", nargs="*", help="passed to fp after --")
+
+    c = sub.add_parser("compare", help="diff two result files and flag regressions")
+    c.add_argument("base"); c.add_argument("new")
+    c.add_argument("--height-tol", type=float, default=0.0, help="allowed relative height increase")
+    c.add_argument("--time-tol", type=float, default=0.25, help="allowed relative wall time increase")
+    c.add_argument("--time-slack", type=float, default=0.5, help="wall time increases below this many seconds are noise")
+    c.add_argument("--memory-tol", type=float, default=0.25, help="allowed relative peak RSS increase")
+
+    args = ap.parse_args()
+    sys.exit(cmd_run(args) if args.cmd == "run" else cmd_compare(args))
+
+if __name__ == "__main__":
+    main()
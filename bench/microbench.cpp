@@ -0,0 +1,277 @@
+// micro-benchmarks for the geometry, cluster and exact packing kernels, the checkers and the file I/O
+// self-contained, no benchmark library: every kernel runs in batches sized to take a
+// few milliseconds, repeated, and reported as ns/op median with the 10th/90th percentile
+//
+//   bin/microbench [--filter <substring>] [--reps <n>] [--modules <n>]
+
+#include "floorplanner.h"
+#include <cstdio>
+#include <unistd.h>
+
+namespace
+{
+    // keep the compiler from dropping a result it can prove unused
+    template <class T>
+    void keep(const T &value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // discards everything, the kernels under test print to std::cout
+    struct NullBuffer : std::streambuf
+    {
+        int overflow(int c) override { return c; }
+    };
+
+    struct Options
+    {
+        std::string filter;
+        int reps = 15;
+        int modules = 10000;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // fn(iterations) runs the kernel that many times and returns the time it took in ns,
+    // so kernels with per op setup can leave it out, see loop() for the plain case
+    void run(const Options &opt, const std::string &name, const std::function<double(long)> &fn)
+    {
+        if (!opt.filter.empty() && name.find(opt.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        NullBuffer null;
+        std::streambuf * saved = std::cout.rdbuf(&null);
+
+        // grow the batch until one takes at least 5 ms, so clock resolution does not matter
+        long batch = 1;
+        for (;;)
+        {
+            double ns = fn(batch);
+            if (ns >= 5e6 || batch >= (1L << 30))
+            {
+                break;
+            }
+            batch = ns < 1e3 ? batch * 100 : std::max(batch + 1, long(batch * 5e6 / ns));
+        }
+
+        std::vector<double> perOp;
+        for (int r = 0; r < opt.reps; r++)
+        {
+            perOp.push_back(fn(batch) / batch);
+        }
+
+        std::cout.rdbuf(saved);
+
+        std::sort(perOp.begin(), perOp.end());
+        auto at = [&](double q) { return perOp[std::min<size_t>(perOp.size() - 1, size_t(q * perOp.size()))]; };
+        std::printf("%-36s %14.1f %14.1f %14.1f %10ld\n", name.c_str(), at(0.5), at(0.1), at(0.9), batch);
+        std::fflush(stdout);
+    }
+
+    // times kernel() run back to back
+    std::function<double(long)> loop(const std::function<void()> &kernel)
+    {
+        return [kernel](long n) {
+            auto start = Clock::now();
+            for (long i = 0; i < n; i++)
+            {
+                kernel();
+            }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+    }
+
+    std::vector<std::unique_ptr<Module>> randomModules(int n, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> side(4, 100);
+
+        std::vector<std::unique_ptr<Module>> out;
+        out.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            out.push_back(std::unique_ptr<Module>(new Module(i, side(rng), side(rng))));
+        }
+        return out;
+    }
+
+    // a cluster hierarchy over leaves and the clusters it owns
+    struct Hierarchy
+    {
+        std::vector<std::unique_ptr<Module>> leaves;
+        std::vector<std::unique_ptr<Cluster>> clusters;
+        Cluster * root = nullptr;
+    };
+
+    // every level holds one leaf and the next level, depth levels in total
+    Hierarchy deepHierarchy(int depth)
+    {
+        Hierarchy h;
+        h.leaves = randomModules(depth, 1);
+
+        Cluster * below = nullptr;
+        for (int d = depth - 1; d >= 0; d--)
+        {
+            std::vector<Module *> members = {h.leaves[d].get()};
+            if (below)
+            {
+                members.push_back(below);
+            }
+            h.clusters.push_back(std::make_unique<Cluster>(members));
+            below = h.clusters.back().get();
+        }
+        h.root = below;
+        return h;
+    }
+
+    // one cluster directly holding width leaves
+    Hierarchy wideHierarchy(int width)
+    {
+        Hierarchy h;
+        h.leaves = randomModules(width, 2);
+        h.clusters.push_back(std::make_unique<Cluster>(h.leaves));
+        h.root = h.clusters.back().get();
+        return h;
+    }
+
+    void writeInstance(const std::string &file, int n)
+    {
+        std::ofstream out(file);
+        out << "MODULE_SIZE " << n << "\nID\tW\t\tH\n";
+        for (auto &m : randomModules(n, 3))
+        {
+            out << m->getId() << "\t" << m->getOrgWidth() << "\t\t" << m->getOrgHeight() << "\n";
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter")
+        {
+            opt.filter = argv[i + 1];
+        }
+        else if (arg == "--reps")
+        {
+            opt.reps = std::max(1, std::atoi(argv[i + 1]));
+        }
+        else if (arg == "--modules")
+        {
+            opt.modules = std::max(1, std::atoi(argv[i + 1]));
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--reps <n>] [--modules <n>]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%-36s %14s %14s %14s %10s\n", "benchmark", "ns/op median", "p10", "p90", "batch");
+
+    // cluster kernels on deep and wide hierarchies
+    for (int size : {16, 256})
+    {
+        Hierarchy deep = deepHierarchy(size);
+        Hierarchy wide = wideHierarchy(size * 16);
+        std::string d = "/deep" + std::to_string(size);
+        std::string w = "/wide" + std::to_string(size * 16);
+
+        int step = 0;
+        run(opt, "Cluster::getCenter" + d, loop([&]() { keep(deep.root->getCenter()); }));
+        run(opt, "Cluster::getCenter" + w, loop([&]() { keep(wide.root->getCenter()); }));
+        run(opt, "Cluster::setPosition" + d, loop([&]() { step++; deep.root->setPosition(Point(step & 1023, step & 511)); }));
+        run(opt, "Cluster::setPosition" + w, loop([&]() { step++; wide.root->setPosition(Point(step & 1023, step & 511)); }));
+        run(opt, "Cluster::rotate" + d, loop([&]() { deep.root->rotate(); }));
+        run(opt, "Cluster::rotate" + w, loop([&]() { wide.root->rotate(); }));
+    }
+
+    // exact small cluster search, outline at about 80% utilization
+    for (int size : {4, 6})
+    {
+        auto owned = randomModules(size, 4);
+        std::vector<Module *> cluster;
+        long area = 0;
+        int width = 0;
+        for (auto &mod : owned)
+        {
+            cluster.push_back(mod.get());
+            area += mod->getOrgWidth() * mod->getOrgHeight();
+            width = std::max(width, std::min(mod->getOrgWidth(), mod->getOrgHeight()));
+        }
+        width = std::max<int>(width, std::ceil(std::sqrt(area / 0.8)));
+
+        ExactPlacement placement;
+        run(opt, "packExact/" + std::to_string(size), loop([&]() {
+            keep(packExact(cluster, width, std::numeric_limits<int>::max(), 0, Deadline(), placement));
+        }));
+    }
+
+    // parser and writer on a synthetic instance of opt.modules modules
+    std::string dir = "/tmp/microbench_" + std::to_string(getpid());
+    std::filesystem::create_directories(dir);
+    std::string input = dir + "/in.txt";
+    std::string output = dir + "/out.txt";
+    writeInstance(input, opt.modules);
+
+    std::string m = "/" + std::to_string(opt.modules);
+
+    // initialize() appends, so every parse gets a fresh floorplanner built outside the timed part
+    run(opt, "Floorplanner::initialize" + m, [&](long n) {
+        std::vector<std::unique_ptr<Floorplanner>> fresh;
+        for (long i = 0; i < n; i++)
+        {
+            fresh.push_back(std::make_unique<Floorplanner>());
+        }
+
+        auto start = Clock::now();
+        for (auto &f : fresh)
+        {
+            f->initialize(input);
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    });
+
+    // a legal skyline packing in an outline of about 80% utilization, set up quietly
+    NullBuffer null;
+    std::streambuf * saved = std::cout.rdbuf(&null);
+    Floorplanner fp;
+    fp.initialize(input);
+    Spec spec;
+    spec.problemType = 1;
+    spec.targetWidth = std::ceil(std::sqrt(opt.modules * 52.0 * 52.0 / 0.8));
+    spec.targetHeight = 1e9;
+    fp.setSpec(spec);
+    fp.skylineOpt();
+    std::cout.rdbuf(saved);
+
+    run(opt, "Floorplanner::writeOutput" + m, loop([&]() { fp.writeOutput(output); }));
+
+    // checker backends on a legal packing, so all of them have to look at every module
+    run(opt, "Floorplanner::validityCheck" + m, loop([&]() { keep(fp.validityCheck()); }));
+    run(opt, "Floorplanner::isLegal" + m, loop([&]() { keep(fp.isLegal()); }));
+    run(opt, "Floorplanner::isLegalSweep" + m, loop([&]() { keep(fp.isLegalSweep()); }));
+    run(opt, "Floorplanner::isLegalGrid" + m, loop([&]() { keep(fp.isLegalGrid()); }));
+
+    // packers on the first 500 modules, bottom-left fill grows with modules times levels
+    std::string small = dir + "/small.txt";
+    writeInstance(small, std::min(opt.modules, 500));
+    saved = std::cout.rdbuf(&null);
+    Floorplanner packing;
+    packing.initialize(small);
+    spec.targetWidth = std::ceil(std::sqrt(std::min(opt.modules, 500) * 52.0 * 52.0 / 0.8));
+    packing.setSpec(spec);
+    std::cout.rdbuf(saved);
+
+    std::string k = "/" + std::to_string(std::min(opt.modules, 500));
+    run(opt, "Floorplanner::skylineOpt" + k, loop([&]() { keep(packing.skylineOpt()); }));
+    run(opt, "Floorplanner::blfOpt" + k, loop([&]() { keep(packing.blfOpt()); }));
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,75 @@
+import argparse, math, random
+from pathlib import Path
+
+# synthetic instances in the MODULE_SIZE format plus a matching spec file
+#   python3 gen_instance.py --modules 100000 --dist heavy --utilization 0.85 --out-dir gen
+# writes gen/<name>.in and gen/<name>.spec, name defaults to <dist>_<modules>
+
+CHUNK = 1 << 16     # lines per write, keeps 10M module instances out of memory
+
+def sampler(dist, lo, hi, rng):
+    # returns a function giving one (w, h) per call
+    if dist == "uniform":
+        return lambda: (rng.randint(lo, hi), rng.randint(lo, hi))
+
+    if dist == "heavy":
+        # pareto sides, most modules near lo and a long tail of big macros
+        def heavy():
+            side = lambda: min(hi, int(lo * rng.paretovariate(1.5)))
+            return side(), side()
+        return heavy
+
+    if dist == "identical":
+        # a handful of shapes repeated over and over, like standard cells or memories
+        shapes = [(rng.randint(lo, hi), rng.randint(lo, hi)) for _ in range(4)]
+        return lambda: rng.choice(shapes)
+
+    if dist == "sliver":
+        # one side at lo, the other anywhere up to hi, either way up
+        def sliver():
+            w, h = rng.randint(lo, max(lo, lo * 2)), rng.randint(lo, hi)
+            return (w, h) if rng.random() < 0.5 else (h, w)
+        return sliver
+
+    raise ValueError(f"unknown distribution {dist}")
+
+def main():
+    ap = argparse.ArgumentParser(description="Generate a synthetic floorplanning instance")
+    ap.add_argument("--modules", type=int, default=1000)
+    ap.add_argument("--dist", choices=["uniform", "heavy", "identical", "sliver"], default="uniform")
+    ap.add_argument("--min-side", type=int, default=4)
+    ap.add_argument("--max-side", type=int, default=100)
+    ap.add_argument("--utilization", type=float, default=0.8, help="module area over the target outline area")
+    ap.add_argument("--aspect", type=float, default=1.0, help="target height over width")
+    ap.add_argument("--problem-type", type=int, default=1, help="0 for the exact ILP category, 1 otherwise")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--out-dir", default="gen")
+    ap.add_argument("--name", default="")
+    args = ap.parse_args()
+
+    rng = random.Random(args.seed)
+    draw = sampler(args.dist, args.min_side, args.max_side, rng)
+    name = args.name or f"{args.dist}_{args.modules}"
+    out = Path(args.out_dir); out.mkdir(parents=True, exist_ok=True)
+
+    area = 0; longest = 0
+    with (out / f"{name}.in").open("w") as f:
+        f.write(f"MODULE_SIZE {args.modules}\nID\tW\t\tH\n")
+        for start in range(0, args.modules, CHUNK):
+            lines = []
+            for i in range(start, min(args.modules, start + CHUNK)):
+                w, h = draw()
+                area += w * h; longest = max(longest, min(w, h))
+                lines.append(f"{i}\t{w}\t\t{h}\n")
+            f.writelines(lines)
+
+    # outline of the requested shape and utilization, wide enough for every module
+    # standing on its short side
+    width = max(longest, math.ceil(math.sqrt(area / (args.utilization * args.aspect))))
+    height = math.ceil(area / (args.utilization * width))
+    (out / f"{name}.spec").write_text(f"{args.problem_type}\n{width}\t{height}\n")
+
+    print(f"{out / name}.in: {args.modules} modules, area {area}, outline {width} x {height}")
+
+if __name__ == "__main__":
+    main()
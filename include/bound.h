@@ -0,0 +1,24 @@
+#ifndef _BOUND_H_
+#define _BOUND_H_
+
+#include "util.h"
+#include "module.h"
+
+// combinatorial lower bounds on the floorplan height for a fixed outline width
+// modules may rotate, so every bound only uses what holds in both orientations
+struct LowerBound
+{
+    int area = 0;       // total area / width, rounded up
+    int tallest = 0;    // the tallest height some module cannot avoid
+    int mmv = 0;        // Martello-Monaci-Vigo style bound on wide and medium modules
+
+    LowerBound() {}
+    LowerBound(const std::vector<Module *> &modules, int targetWidth);
+
+    int get() const { return std::max(area, std::max(tallest, mmv)); }
+};
+
+// relative gap between a height and a bound, 0 when the height is proven optimal
+double heightGap(int height, int bound);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include "util.h"
+#include "module.h"
+#include "spec.h"
+#include <cstdint>
+
+// final placement of a run and what it achieved, in module order
+struct CacheEntry
+{
+    std::vector<int> x, y;
+    std::vector<char> rotated;
+    int height = 0;
+    int bound = 0;
+    bool optimal = false;
+};
+
+// content addressed result cache
+// a directory with one small binary file per key, named after the key in hex.
+// Reading an entry touches its modification time, and storing evicts the least
+// recently used entries until the directory fits in maxBytes again
+class ResultCache
+{
+public:
+    ResultCache(const std::string &dir, uintmax_t maxBytes);
+
+    // 64 bit FNV-1a over the module table, the spec and the solver parameters
+    static uint64_t key(const std::vector<Module *> &modules, const Spec &spec, const std::string &parameters);
+
+    // false on a miss or an entry that does not match n modules
+    bool load(uint64_t key, size_t n, CacheEntry &entry);
+    void store(uint64_t key, const CacheEntry &entry);
+
+private:
+    std::filesystem::path path(uint64_t key) const;
+    void evict();
+
+    std::filesystem::path dir_;
+    uintmax_t maxBytes_;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _COMPACTOR_H_
+#define _COMPACTOR_H_
+
+#include "util.h"
+#include "module.h"
+#include "deadline.h"
+
+// longest path compaction
+// builds the vertical (below) and horizontal (left of) constraint graphs of the
+// current placement and pushes every module as far down / left as they allow,
+// alternating the two directions until nothing moves
+class Compactor
+{
+public:
+    Compactor(const std::vector<Module *> &modules);
+
+    // returns the height after compaction, stops between passes once the deadline expires
+    int compact(const Deadline &deadline = Deadline(), int maxPasses = 16);
+
+private:
+    // one direction of compaction on generic coordinates:
+    // pos/len along the axis being compacted, cross/crossLen along the other one
+    // returns true if any module moved
+    bool compactAxis(std::vector<int> &pos, const std::vector<int> &len, const std::vector<int> &cross, const std::vector<int> &crossLen);
+
+    std::vector<Module *> modules_;
+    std::vector<std::vector<int>> preds_;   // constraint graph, reused across passes
+};
+
+#endif
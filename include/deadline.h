@@ -0,0 +1,60 @@
+#ifndef _DEADLINE_H_
+#define _DEADLINE_H_
+
+#include "util.h"
+#include <chrono>
+#include <atomic>
+
+// wall clock budget shared by every stage of the flow
+// a default constructed deadline never expires
+// copies share one cancellation flag, cancel() makes all of them expire at once
+class Deadline
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    Deadline() : start_(clock::now()), unlimited_(true), cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+    Deadline(double seconds) : start_(clock::now()), unlimited_(false), cancelled_(std::make_shared<std::atomic<bool>>(false))
+    {
+        end_ = start_ + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(std::max(0.0, seconds)));
+    }
+
+    bool isUnlimited() const { return unlimited_; }
+    bool expired() const { return cancelled() || (!unlimited_ && clock::now() >= end_); }
+
+    void cancel() const { *cancelled_ = true; }
+    bool cancelled() const { return *cancelled_; }
+
+    // same end time with a cancellation flag of its own
+    Deadline fork() const
+    {
+        Deadline d = *this;
+        d.cancelled_ = std::make_shared<std::atomic<bool>>(cancelled());
+        return d;
+    }
+
+    double elapsed() const { return std::chrono::duration<double>(clock::now() - start_).count(); }
+
+    double remaining() const
+    {
+        if (cancelled())
+        {
+            return 0.0;
+        }
+        if (unlimited_)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        return std::max(0.0, std::chrono::duration<double>(end_ - clock::now()).count());
+    }
+
+    // a stage's own time cap clipped to what is left of the budget
+    double limit(double cap) const { return std::min(cap, remaining()); }
+
+private:
+    clock::time_point start_, end_;
+    bool unlimited_;
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+#endif
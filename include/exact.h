@@ -0,0 +1,34 @@
+#ifndef _EXACT_H_
+#define _EXACT_H_
+
+#include "util.h"
+#include "module.h"
+#include "deadline.h"
+
+// largest module count with a compiled exact packer
+constexpr int exactMaxModules = 10;
+
+// search nodes before giving up, a few seconds at most, hard clusters go to the ILP
+constexpr long exactNodeLimit = 1L << 23;
+
+enum class ExactStatus
+{
+    Optimal,    // placement holds a lowest packing below the limit
+    NoneBelow,  // proven that nothing is lower than the limit
+    Aborted     // deadline or node limit hit first, placement holds the best one found if any
+};
+
+struct ExactPlacement
+{
+    std::vector<int> x, y;
+    std::vector<char> rotated;
+    int height = 0;
+    long nodes = 0;
+};
+
+// exact strip packing of up to exactMaxModules modules without an ILP
+// looks for the lowest packing into targetWidth with a height below limit,
+// stops early once one meets lowerBound
+ExactStatus packExact(const std::vector<Module *> &modules, int targetWidth, int limit, int lowerBound, const Deadline &deadline, ExactPlacement &out);
+
+#endif
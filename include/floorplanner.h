@@ -6,6 +6,18 @@
 #include "module.h"
 #include "spec.h"
 #include "cluster.h"
+#include "packer.h"
+#include "tempering.h"
+#include "compactor.h"
+#include "formulation.h"
+#include "deadline.h"
+#include "bound.h"
+#include "geometry.h"
+#include "profile.h"
+#include "cache.h"
+#include "exact.h"
+#include "grid.h"
+#include <mutex>
 
 class Floorplanner 
 {
@@ -16,18 +28,113 @@ public:
     void initialize(std::string inputFile);
     void setSpec(Spec s) { spec = s; }
     void setSpec(std::string specFile) { spec = Spec(specFile); }
+    void setStrategy(std::string s) { strategy = s; }
+    void setTempering(const TemperingOptions &opt) { tempering = opt; }
+    void setCompaction(bool c) { compaction = c; }
+    void setWindow(int k, double seconds) { windowSize = k; windowTime = seconds; }
+    void setDeadline(const Deadline &d) { deadline = d; }
+    void setGroup(int k) { groupSize = k; }
+    void setEncoding(Encoding e) { encoding = e; }
+    void setRepairInterval(int nodes) { repairInterval = nodes; }
+    void setExactSize(int n) { exactSize = std::min(n, exactMaxModules); }
+    void setLogging(const std::string &file, bool console) { logFile = file; logConsole = console; }     // taken by the solver when it is made
+    void setTelemetry(std::ostream *sink) { telemetry = sink; }
+    void setPortfolio(const std::vector<std::string> &s, int target) { portfolio = s; goodEnough = target; }
+    void setIncumbentCallback(std::function<void(Floorplanner &)> f) { onIncumbent = f; }
+    void copyFrom(const Floorplanner &other);
+    void cancel();
+    bool isOptimal() const { return provenOptimal; }
+    int getLowerBound();
+    const Spec &getSpec() const { return spec; }
+    std::vector<Module *> getModules();
+    int getHeight();
     void writeOutput(std::string outputFile);
     bool validityCheck();
     float category0Opt();
     float category1Opt();      
+    float skylineOpt();
+    float blfOpt();
+    float annealOpt();
+    float temperingOpt();
+    float lnsOpt();
+    float portfolioOpt();
+    float category0Bisect();
+    float augmentOpt();
+    float clusterOpt();
+    float compact();
+    bool applyEco(const std::string &previousOutput, const std::string &deltaFile);
+    bool saveIncumbent();
+    bool isLegal();
+    bool isLegalSweep();
+    bool isLegalSweep(const std::vector<Module *> &list);  // only these modules, the others may not be placed yet
+    bool isLegalGrid();
+    bool writeIncumbent(std::string outputFile);
+    std::string parameters() const;
+    bool restoreFrom(const CacheEntry &entry);
+    CacheEntry toCacheEntry();
     
 private:
-    bool solveCluster(Cluster * c, float targetWidth, float targetHeight);
+    // best legal placement seen so far, written out if the budget runs out
+    struct Incumbent
+    {
+        std::vector<int> x, y;
+        std::vector<char> rotated;
+        int height = -1;
+    };
+
+    // proven optimal placement of a cluster, one entry per slot of the canonical
+    // order, lying is set when the module is placed with its long side horizontal
+    struct ClusterMemo
+    {
+        std::vector<int> x, y;
+        std::vector<char> lying;
+        int height = 0;
+    };
+
+    void restoreIncumbent();
+    bool insideOutline(const std::vector<Module *> &list);
+
+    // made on first use with the logging and telemetry settings, so floorplanners that
+    // only run heuristics and checks never touch Gurobi
+    Solver &solver();
+
+    std::vector<ModuleVars> buildModel(const std::vector<Module *> &clusterModules, float targetWidth, float targetHeight, int lowerBound);
+    void guideModel(const std::vector<Module *> &list, const std::vector<ModuleVars> &vars, bool hint);
+    Solver::Assignment repairNode(const std::vector<Module *> &list, const std::vector<ModuleVars> &vars, float targetWidth, float targetHeight, const std::function<double(const std::string &)> &relaxed, double best);
+    bool solveWindow(const std::vector<Module *> &window, const std::vector<Obstacle> &obstacles, int yLow, int yHigh, double timeLimit, int topFloor = 0);
+    void releaseWindow();
+
+    // lowerBound/upperBound are known limits on the height, 0 when unknown
+    bool solveCluster(Cluster * c, float targetWidth, float targetHeight, int lowerBound = 0, int upperBound = 0);
     
     std::vector<std::unique_ptr<Module>> modules;
     std::vector<std::unique_ptr<Cluster>> clusters;
     Spec spec;
-    Solver solver_;
+    std::string strategy;           // empty picks by spec.problemType
+    TemperingOptions tempering;
+    bool compaction = true;         // run compact() after every strategy
+    int windowSize = 10;            // modules re-optimized together by lnsOpt
+    double windowTime = 10.0;       // ILP time cap per window or group in seconds
+    int groupSize = 8;              // modules added per step by augmentOpt, per cluster by clusterOpt
+    Encoding encoding = Encoding::BigM;   // non-overlap encoding of every ILP
+    int repairInterval = 100;       // MIP nodes between repairNode runs in solveCluster, 0 for none
+    int exactSize = 7;              // solveCluster uses packExact() up to this many modules
+    std::string logFile = "gurobi.log";
+    bool logConsole = true;
+    std::ostream *telemetry = nullptr;  // NDJSON solver progress, shared with portfolio workers
+    Deadline deadline;              // wall clock budget of the whole flow
+    Incumbent incumbent;
+    std::mutex incumbentMutex;
+    std::function<void(Floorplanner &)> onIncumbent;   // told about every new incumbent
+    bool provenOptimal = false;     // set when the ILP proved optimality on the whole instance
+    std::vector<std::string> portfolio = {"shelf", "skyline", "tempering", "ilp", "lns"};
+    int goodEnough = 0;             // portfolio stops once a result is at least this low
+    int heightBound = -1;           // cached getLowerBound()
+    std::map<std::vector<int>, ClusterMemo> clusterMemo;   // keyed by target and sorted module sides
+    int windowModules = -1;         // size of the window model kept in the solver, -1 for none
+    int windowObstacles = 0;        // obstacle slots of that model
+    std::shared_ptr<Solver> solver_;   // deleter bound in solver(), this header needs no Gurobi symbols
+    std::mutex solverMutex;            // guards solver_ against cancel() while it is made
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef _FORMULATION_H_
+#define _FORMULATION_H_
+
+#include "solver.h"
+
+// names of the ILP variables describing one module
+struct ModuleVars
+{
+    std::string x, y, r;    // left, bottom, rotation flag
+    double w, h;            // unrotated width and height
+};
+
+// a fixed rectangle the free modules must stay clear of
+struct Obstacle
+{
+    double x, y, w, h;
+};
+
+// how the left/below/right/above disjunction of a non-overlap pair is written
+// BigM:      two binaries p, q and four big-M rows, the LP relaxation is weak but cheap
+// Indicator: one binary per side, exactly one of them set, each side an indicator
+//            constraint that Gurobi branches on directly, no M anywhere
+enum class Encoding
+{
+    BigM,
+    Indicator
+};
+
+// where module a sits relative to b in a non-overlap pair, the (p, q) order of addNonOverlap
+enum class Relation
+{
+    Left,
+    Below,
+    Right,
+    Above
+};
+
+// relation of two rectangles that do not overlap
+Relation relation(const Obstacle &a, const Obstacle &b);
+
+// "bigm" or "indicator", false for anything else
+bool parseEncoding(const std::string &name, Encoding &encoding);
+const char * encodingName(Encoding encoding);
+
+// builds the floorplanning ILP on top of a Solver
+// keeps the variable naming of solveCluster so every flow produces the same model
+// with update set it restates a model it built before with the same tags instead,
+// every add call then moves the bounds, coefficients and rhs of the existing
+// variables and rows in place, only the big-M encoding can be changed that way
+class Formulation
+{
+public:
+    Formulation(Solver &solver, double bigM, Encoding encoding = Encoding::BigM, bool update = false) : solver_(solver), M(bigM), encoding_(encoding), update_(update) {}
+
+    // x in [0, xMax], y in [yMin, yMax], r fixed to 0 when rotating cannot fit
+    ModuleVars addModule(const std::string &tag, double w, double h, double xMax, double yMin, double yMax, bool canRotate = true);
+
+    // right edge inside the outline width and top edge below the height variable
+    void addOutline(const ModuleVars &m, const std::string &tag, double width, const std::string &heightVar);
+
+    // the module pair must not overlap, left/right/below/above picked by p and q
+    void addNonOverlap(const ModuleVars &a, const ModuleVars &b, const std::string &tag);
+
+    // the module must not overlap the fixed rectangle
+    void addObstacle(const ModuleVars &a, const Obstacle &o, const std::string &tag);
+
+    // addObstacle for each of them, tagged <tag>_o<k>
+    void addObstacles(const ModuleVars &a, const std::vector<Obstacle> &obstacles, const std::string &tag);
+
+    // branching order and hints, higher priorities are decided first
+    // the module's rotation flag, and the side binaries of the pair added under tag
+    void prioritize(const ModuleVars &a, int priority);
+    void prioritizePair(const std::string &tag, int priority);
+    void hintRotation(const ModuleVars &a, bool rotated, int priority);
+    void hintPair(const std::string &tag, Relation rel, int priority);
+
+    // values of the side binaries of the pair added under tag that select rel
+    std::vector<std::pair<std::string, double>> pairValues(const std::string &tag, Relation rel) const;
+
+private:
+    // the four sides as (vars, sense, rhs) rows, a on the left, below, right and above
+    struct SideRow
+    {
+        std::vector<std::pair<std::string, double>> vars;
+        char sense;
+        double rhs;
+    };
+    void addSides(const SideRow (&sides)[4], const std::string &tag);
+
+    // add, or change in place when updating
+    void variable(const std::string &name, double lb, double ub, char type);
+    void row(const std::string &name, const std::vector<std::pair<std::string, double>> &vars, char sense, double rhs);
+
+    Solver &solver_;
+    double M;
+    Encoding encoding_;
+    bool update_;
+};
+
+#endif
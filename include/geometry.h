@@ -0,0 +1,14 @@
+#ifndef _GEOMETRY_H_
+#define _GEOMETRY_H_
+
+#include "formulation.h"
+
+// merge fixed rectangles into a small set of disjoint rectangles covering the same area
+// the union is cut into horizontal slabs at every top/bottom edge, slabs with the
+// same covered x intervals are glued back together vertically, so the result
+// grows with the complexity of the outline of the union rather than with its count
+// free gaps narrower than minGap (nothing movable fits there) are covered as well,
+// including the gaps against the outline edges 0 and width
+std::vector<Obstacle> mergeObstacles(const std::vector<Obstacle> &rects, double minGap, double width);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _GRID_H_
+#define _GRID_H_
+
+#include "util.h"
+#include <cstdint>
+
+// occupancy bitmap of an integer outline, one bit per unit cell and a row of
+// 64-bit words per y, rows are added on demand so the height may stay open
+// every query works a word at a time, so its cost is about area / 64
+class OccupancyGrid
+{
+public:
+    OccupancyGrid(int width, int height = 0);
+
+    // true if [x, x + w) x [y, y + h) is inside the width and every cell is free
+    bool fits(int x, int y, int w, int h) const;
+
+    // marks the cells, returns false if one of them was taken already or the
+    // rectangle is not inside the width, which then marks nothing
+    bool claim(int x, int y, int w, int h);
+
+    // claim() that also keeps what findLowestLeft() needs up to date
+    bool place(int x, int y, int w, int h);
+
+    // lowest, then leftmost, spot where a w x h rectangle fits
+    // only y = 0 and tops of placed rectangles are tried, the lowest fit is always on one
+    bool findLowestLeft(int w, int h, int &x, int &y) const;
+
+    int getWidth() const { return width_; }
+    int getRows() const { return rows_; }
+
+private:
+    const uint64_t * row(int y) const { return &bits_[size_t(y) * words_]; }
+    uint64_t * row(int y) { return &bits_[size_t(y) * words_]; }
+    void grow(int rows);
+
+    int width_;
+    int words_;                 // per row
+    int rows_ = 0;
+    std::vector<uint64_t> bits_;
+    std::vector<int> run_;          // longest free run per row
+    std::set<int> levels_ = {0};    // y = 0 and the tops of placed rectangles, minus full rows
+};
+
+#endif
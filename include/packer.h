@@ -0,0 +1,48 @@
+#ifndef _PACKER_H_
+#define _PACKER_H_
+
+#include "util.h"
+#include "module.h"
+
+// a floorplan encoded as a packing order plus a rotation flag per module
+// the heuristic strategies all search over this and decode it with the skyline packer
+struct Sequence
+{
+    std::vector<int> order;     // indices into the module list, packed front to back
+    std::vector<char> rotated;  // rotated[i] == 1 if module i is turned 90 degrees
+};
+
+// bottom-left skyline packer for a strip of fixed width
+// each module goes to the lowest (then leftmost) spot on the skyline where it fits
+class SkylinePacker
+{
+public:
+    SkylinePacker(const std::vector<Module *> &modules, int targetWidth);
+
+    // decode seq into xs/ys, returns the height of the packing
+    int pack(const Sequence &seq, std::vector<int> &xs, std::vector<int> &ys);
+
+    // write a decoded packing back into the modules
+    void apply(const Sequence &seq, const std::vector<int> &xs, const std::vector<int> &ys);
+
+    int getWidth(int i, bool r) const { return r ? height_[i] : width_[i]; }
+    int getHeight(int i, bool r) const { return r ? width_[i] : height_[i]; }
+    int size() const { return (int)width_.size(); }
+    int getTargetWidth() const { return targetWidth_; }
+
+private:
+    struct Segment
+    {
+        int x, width, y;
+    };
+
+    std::vector<Module *> modules_;
+    std::vector<int> width_, height_;
+    std::vector<Segment> skyline_;
+    int targetWidth_;
+};
+
+// sequence sorted by tallest height first with every module standing upright
+Sequence tallestFirst(const SkylinePacker &packer);
+
+#endif
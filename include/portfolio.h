@@ -0,0 +1,34 @@
+#ifndef _PORTFOLIO_H_
+#define _PORTFOLIO_H_
+
+#include "floorplanner.h"
+
+// races several strategies against each other, one thread each
+// every worker solves its own copy of the instance and reports legal results to
+// the collector, which keeps the best one in the base floorplanner and stops the
+// others once a result is proven optimal or at least as low as goodEnough
+class Portfolio
+{
+public:
+    Portfolio(Floorplanner &base, const std::vector<std::string> &strategies, int goodEnough = 0);
+
+    // blocks until every worker is done, returns the best height (-1 if none)
+    int run();
+
+    const std::string &getWinner() const { return bestStrategy_; }
+
+private:
+    void collect(size_t k, Floorplanner &fp);
+
+    Floorplanner &base_;
+    std::vector<std::string> strategies_;
+    std::vector<std::unique_ptr<Floorplanner>> workers_;
+    std::mutex mutex_;
+    int goodEnough_;
+    int bestHeight_ = -1;
+    bool bestOptimal_ = false;
+    std::string bestStrategy_;
+    bool done_ = false;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "util.h"
+#include <chrono>
+#include <ctime>
+
+// pipeline instrumentation, off until enableProfile() and/or enableTrace()
+// while both are off every hook below costs two relaxed atomic loads
+void enableProfile();
+bool profiling();
+
+// Chrome trace_event recording (chrome://tracing, Perfetto): every ScopedPhase
+// becomes one complete event on its thread's track, kept in a ring buffer of the
+// last capacity events so long runs cost a fixed amount of memory
+void enableTrace(size_t capacity = 1 << 20);
+bool tracing();
+
+// name the calling thread's track, threads that use the same name share a track,
+// e.g. the short lived sweep threads of one tempering replica
+void setTraceThread(const std::string &name);
+
+// a pointer to a copy of name that lives until exit, for phase names built at run time
+const char * internName(const std::string &name);
+
+// add n to a named counter, e.g. constraints built per family
+void countEvent(const char * name, long n = 1);
+
+// add a phase timed somewhere else, e.g. the presolve time Gurobi reports
+void addPhase(const char * name, double wallSeconds);
+
+// times its own lifetime into the phase name: wall time, CPU time of the calling
+// thread, and the allocations made meanwhile (by any thread, the counters are global)
+// nested phases are counted in the outer one as well
+// with tracing on it also records the lifetime as a trace event
+class ScopedPhase
+{
+public:
+    explicit ScopedPhase(const char * name);
+    ~ScopedPhase();
+
+    ScopedPhase(const ScopedPhase &) = delete;
+    ScopedPhase &operator=(const ScopedPhase &) = delete;
+
+private:
+    const char * name_;
+    bool active_, traced_;
+    std::chrono::steady_clock::time_point wall_;
+    double cpu_;
+    long allocs_, bytes_;
+};
+
+// every phase and counter so far, plus peak RSS and allocation totals, as one JSON object
+void writeProfile(std::ostream &out);
+
+// the events in the ring buffer as a trace_event JSON object, oldest first
+void writeTrace(std::ostream &out);
+
+#endif
@@ -3,29 +3,128 @@
 
 #include "gurobi_c++.h"
 #include "util.h"
+#include "profile.h"
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
 
 class Solver 
 {
 public:
+    // full assignment as (variable, value) pairs
+    using Assignment = std::vector<std::pair<std::string, double>>;
+
+    // heuristic run inside the MIP search at nodes whose relaxation solved to optimality
+    // relaxed(name) is the node relaxation value, incumbent the best objective so far
+    // (GRB_INFINITY before the first one), returns a solution to offer or nothing
+    using NodeHeuristic = std::function<Assignment(const std::function<double(const std::string &)> &relaxed, double incumbent)>;
+
+    // one point of the telemetry timeline, infinite objective/bound/gap mean not known yet
+    struct Progress
+    {
+        double time;            // seconds since the solver was created
+        int solve;              // optimize() call it belongs to, counted from 1
+        std::string event;      // start, progress, incumbent or done
+        double objective;       // best integer objective
+        double bound;           // best bound
+        double gap;             // relative gap as Gurobi's MIPGap
+        double nodes;           // explored branch and bound nodes
+        double work;            // Gurobi work units, deterministic unlike time
+    };
+
+    // size and numerics of the built model, families are constraint names without their tag
+    struct ModelStats
+    {
+        int continuous = 0, binary = 0, integer = 0;
+        std::map<std::string, int> rows;            // linear rows per family
+        std::map<std::string, int> indicators;      // indicator constraints per family
+        long nonzeros = 0;                          // of rows and indicator rows together
+        double coefMin = GRB_INFINITY, coefMax = 0.0;     // nonzero |coefficient|, the big-M shows up here
+        double rhsMin = GRB_INFINITY, rhsMax = 0.0;       // nonzero |rhs|
+        double boundMin = GRB_INFINITY, boundMax = 0.0;   // nonzero finite |bound|
+    };
+
     Solver();
+    ~Solver();
     void addVariable(const std::string &name, double lowerbound, double upperbound, char type);
     void addConstraint(const std::string &name, const std::vector<std::pair<std::string, double>> &vars, char sense, double rhs);
+    // the linear constraint only has to hold while the binary variable flag equals value
+    void addIndicator(const std::string &name, const std::string &flag, int value, const std::vector<std::pair<std::string, double>> &vars, char sense, double rhs);
     void setObjective(const std::vector<std::pair<std::string, double>> &vars, char sense);
     void optimize();
     void reset();
     double getObjectiveValue() const;
     double getVariableValue(const std::string &name) const;
     void setTimeLimit(double seconds);
+    void setStart(const std::string &name, double value);
+    void setBestObjStop(double value);   // stop once an incumbent is at least this good
+    void setCutoff(double value);        // ignore solutions worse than this
+    void setSolutionLimit(int count);    // stop after this many feasible solutions
+    void setBranchPriority(const std::string &name, int priority);      // higher is branched on first
+    void setHint(const std::string &name, double value, int priority);  // likely value, steers the search but is not a start
+
+    // in place changes to a built model, the next optimize() keeps presolve,
+    // basis and incumbent information instead of starting over like reset()
+    void setUpperBound(const std::string &name, double ub);
+    void setLowerBound(const std::string &name, double lb);
+    void setRHS(const std::string &constraint, double rhs);
+    void setCoefficient(const std::string &constraint, const std::string &var, double coef);
+    void setObjectiveCoefficient(const std::string &var, double coef);
+
     int getSolutionCount();
-    int getStatus() { return model_->get(GRB_IntAttr_Status); } 
+    int getStatus() { return model().get(GRB_IntAttr_Status); } 
+
+    // stop a running optimize() from another thread, later calls return right away
+    void terminate();
+
+    // run heuristic at most once every interval nodes during optimize(), reset() drops it
+    void setNodeHeuristic(NodeHeuristic heuristic, int interval);
+
+    // keep a timeline of every optimize() in memory, each point also goes
+    // to sink as one NDJSON line if there is one
+    void setTelemetry(bool record, std::ostream *sink = nullptr);
+    const std::vector<Progress> &getTimeline() const { return timeline_; }
+
+    // statistics of the model as built so far, from Gurobi's model attributes and
+    // the per family tallies kept as rows are added
+    ModelStats getModelStats();
+    // print them with the time it took to build while the console log is on, and add
+    // them to the telemetry sink if there is one, nothing is computed otherwise
+    void reportModel(double buildMs);
+
+    // Gurobi's own log, an empty file name turns the file off
+    void setLogging(const std::string &logFile, bool console);
 
 private:
+    class Callback;
+
+    double clock() const;
+    void record(const char * event, double objective, double bound, double nodes, double work);
+    static std::string family(const std::string &name);
+    static void widen(double v, double &lo, double &hi);
+
     static int objSense(std::string s);  // 'MIN' for minimization, 'MAX' for maximization
+    GRBVar &var(const std::string &name);
+    GRBConstr &constr(const std::string &name);
+    GRBModel &model();
 
-    std::unique_ptr<GRBEnv> env_;
-    std::unique_ptr<GRBModel> model_;
+    std::unique_ptr<GRBEnv> env_;           // started on the first model()
+    std::unique_ptr<GRBModel> model_;       // made on the first model() after a reset()
+    std::string logFile_;                   // Gurobi log file for the env, none if empty
+    bool console_ = true;
     std::unordered_map<std::string, GRBVar> varmap_;
+    std::unordered_map<std::string, GRBConstr> constrmap_;
     int status_; 
+    std::mutex modelMutex_;                 // guards model_ against terminate() during reset()
+    std::atomic<bool> terminated_{false};
+    std::unique_ptr<Callback> callback_;    // installed on every model
+    std::chrono::steady_clock::time_point start_;
+    std::vector<Progress> timeline_;
+    bool recording_ = false;
+    std::ostream *sink_ = nullptr;
+    int solves_ = 0;
+    ModelStats tally_;                      // rows and indicators per family and indicator numerics, tallied as they are added
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef _TEMPERING_H_
+#define _TEMPERING_H_
+
+#include "packer.h"
+#include "deadline.h"
+#include <random>
+
+struct TemperingOptions
+{
+    int replicas = 1;           // one replica per thread
+    double timeLimit = 10.0;    // wall clock seconds for the whole run
+    int swapInterval = 200;     // moves per replica between two exchange rounds
+    double tMax = 0.0;          // hottest temperature, 0 picks one from the starting height
+    double tMin = 0.0;          // coldest temperature, 0 picks one from the starting height
+    bool cooling = false;       // single chain annealing: cool down over time instead of swapping
+    unsigned seed = 1;
+};
+
+// replica exchange monte carlo over packing sequences
+// every replica walks at its own fixed temperature and neighbouring
+// temperatures trade states periodically, so the cold end gets fed good
+// sequences found by the hot replicas instead of freezing in its first valley
+class Tempering
+{
+public:
+    Tempering(const SkylinePacker &packer, const Sequence &initial);
+
+    // run until the time limit or the deadline, returns the best height found
+    int run(const TemperingOptions &opt, const Deadline &deadline = Deadline());
+
+    const Sequence &getBest() const { return best_; }
+    int getBestHeight() const { return bestHeight_; }
+    void report() const;
+
+private:
+    struct Replica
+    {
+        SkylinePacker packer;
+        Sequence seq, trial, best;
+        std::vector<int> xs, ys;
+        std::mt19937 rng;
+        double cost = 0.0;
+        double bestCost = 0.0;
+        double temperature = 1.0;
+        int height = 0;
+        long proposed = 0, accepted = 0;
+        long swapsProposed = 0, swapsAccepted = 0;
+
+        Replica(const SkylinePacker &p) : packer(p) {}
+    };
+
+    double evaluate(Replica &rep, const Sequence &seq, int &height);
+    void mutate(Replica &rep);
+    void sweep(Replica &rep, int moves);
+
+    std::vector<Replica> replicas_;
+    Sequence initial_, best_;
+    int bestHeight_ = std::numeric_limits<int>::max();
+    bool cooling_ = false;
+};
+
+#endif
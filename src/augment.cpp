@@ -0,0 +1,78 @@
+#include "floorplanner.h"
+
+// successive augmentation
+// modules go in by decreasing area, groupSize at a time. Each step solves an ILP
+// for the new group only, with everything placed before frozen as obstacles, so a
+// step has O(k^2 + k*m) pairs instead of the O(n^2) of the monolithic model
+float Floorplanner::augmentOpt()
+{
+    std::vector<Module *> sorted = getModules();
+    std::stable_sort(sorted.begin(), sorted.end(), [](Module * a, Module * b) {
+        return a->getOrgWidth() * a->getOrgHeight() > b->getOrgWidth() * b->getOrgHeight();
+    });
+
+    int n = sorted.size();
+    int k = std::max(1, groupSize);
+    int yHigh = std::max<int>(spec.targetHeight, 1);
+    int placedTop = 0;
+
+    std::vector<Module *> placed;
+    placed.reserve(n);
+
+    for (int first = 0; first < n; first += k)
+    {
+        int last = std::min(n, first + k);
+        std::vector<Module *> group(sorted.begin() + first, sorted.begin() + last);
+
+        // start: skyline pack the group on top of what is already placed,
+        // which is also what the group keeps if the ILP has nothing better
+        SkylinePacker packer(group, spec.targetWidth);
+        Sequence seq = tallestFirst(packer);
+        std::vector<int> xs, ys;
+        packer.pack(seq, xs, ys);
+        for (auto &y : ys)
+        {
+            y += placedTop;
+        }
+        packer.apply(seq, xs, ys);
+
+        std::vector<Obstacle> obstacles;
+        obstacles.reserve(placed.size());
+        for (auto m : placed)
+        {
+            obstacles.push_back({m->getPosition().x(), m->getPosition().y(), double(m->getRotatedWidth()), double(m->getRotatedHeight())});
+        }
+
+        std::vector<std::pair<Point, bool>> saved;
+        for (auto m : group)
+        {
+            saved.push_back({m->getPosition(), m->isRotated()});
+        }
+
+        // the modules after this group are not placed yet, only what is placed is checked
+        if (!deadline.expired() && solveWindow(group, obstacles, 0, yHigh, deadline.limit(windowTime), placedTop))
+        {
+            std::vector<Module *> check = placed;
+            check.insert(check.end(), group.begin(), group.end());
+            if (!isLegalSweep(check))
+            {
+                std::cout << "Augment: ILP placement of the group overlaps, keeping the skyline one" << std::endl;
+                for (size_t i = 0; i < group.size(); i++)
+                {
+                    group[i]->setRotate(saved[i].second);
+                    group[i]->setPosition(saved[i].first);
+                }
+            }
+        }
+
+        for (auto m : group)
+        {
+            placed.push_back(m);
+            placedTop = std::max(placedTop, int(m->getPosition().y()) + m->getRotatedHeight());
+        }
+
+        std::cout << "Augment: " << placed.size() << "/" << n << " modules placed, height " << placedTop << std::endl;
+    }
+
+    return placedTop;
+}
@@ -0,0 +1,91 @@
+#include "floorplanner.h"
+
+// category 0 by bisection on the height
+// instead of optimizing Y the model only asks "is there a floorplan with Y <= h",
+// stopping at the first feasible solution, and h is bisected between the lower
+// bound and the best known height. The model is built once, each step only moves
+// the upper bound of Y so Gurobi keeps its presolve and search state between steps
+float Floorplanner::category0Bisect()
+{
+    int lo = getLowerBound();
+    int sentinel = int(spec.targetHeight) + 1;   // no feasible height known yet
+    int hi = sentinel;
+
+    // a legal skyline packing is the starting upper bound
+    skylineOpt();
+    Compactor(getModules()).compact(deadline);
+    if (isLegal())
+    {
+        hi = getHeight();
+        saveIncumbent();
+    }
+
+    std::vector<Module *> list = getModules();
+    auto buildStart = std::chrono::steady_clock::now();
+    std::vector<ModuleVars> vars = buildModel(list, spec.targetWidth, spec.targetHeight, lo);
+
+    if (vars.empty())
+    {
+        solver().reset();
+        return hi;
+    }
+
+    guideModel(list, vars, hi < sentinel);
+    solver().reportModel(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count());
+
+    solver().setSolutionLimit(1);
+
+    bool exact = true;
+    while (lo < hi && !deadline.expired())
+    {
+        int mid = lo + (hi - lo) / 2;
+
+        solver().setUpperBound("Y", mid);
+        solver().setTimeLimit(deadline.limit(3600));
+        solver().optimize();
+
+        int status = solver().getStatus();
+
+        if (solver().getSolutionCount() > 0 && status != GRB_INFEASIBLE)
+        {
+            for (size_t i = 0; i < list.size(); i++)
+            {
+                int x = static_cast<int>(std::round(solver().getVariableValue(vars[i].x)));
+                int y = static_cast<int>(std::round(solver().getVariableValue(vars[i].y)));
+                list[i]->setRotate(solver().getVariableValue(vars[i].r) > 0.5);
+                list[i]->setPosition(Point(x, y));
+            }
+
+            // the solution can come in under mid, take the height it actually has
+            Compactor(list).compact(deadline);
+            hi = std::min(mid, getHeight());
+            saveIncumbent();
+            std::cout << "Bisection: height " << hi << " is feasible" << std::endl;
+        }
+        else
+        {
+            // without a proof of infeasibility the final height is not proven optimal
+            if (status != GRB_INFEASIBLE)
+            {
+                exact = false;
+            }
+            std::cout << "Bisection: height " << mid << (status == GRB_INFEASIBLE ? " is infeasible" : " gave no answer in time") << std::endl;
+            lo = mid + 1;
+        }
+    }
+
+    solver().reset();
+
+    if (hi == sentinel)
+    {
+        std::cout << "Bisection found no floorplan within the outline" << std::endl;
+        return 0;
+    }
+
+    if (lo >= hi && exact)
+    {
+        provenOptimal = true;
+    }
+
+    return hi;
+}
@@ -0,0 +1,87 @@
+#include "bound.h"
+
+LowerBound::LowerBound(const std::vector<Module *> &modules, int targetWidth)
+{
+    long long W = targetWidth;
+    if (W <= 0 || modules.empty())
+    {
+        return;
+    }
+
+    // (short side, long side) per module, sorted by short side
+    std::vector<std::pair<long long, long long>> sides;
+    sides.reserve(modules.size());
+
+    long long totalArea = 0;
+    for (auto m : modules)
+    {
+        long long s = std::min(m->getOrgWidth(), m->getOrgHeight());
+        long long t = std::max(m->getOrgWidth(), m->getOrgHeight());
+
+        sides.push_back({s, t});
+        totalArea += s * t;
+
+        // a module longer than the outline has to stand upright
+        long long h = t > W ? t : s;
+        tallest = std::max<long long>(tallest, h);
+    }
+    std::sort(sides.begin(), sides.end());
+
+    area = (totalArea + W - 1) / W;
+
+    // prefix sums over the sorted modules
+    int n = sides.size();
+    std::vector<long long> areaSum(n + 1, 0), heightSum(n + 1, 0), residSum(n + 1, 0);
+    for (int i = 0; i < n; i++)
+    {
+        long long s = sides[i].first;
+        long long t = sides[i].second;
+
+        areaSum[i + 1] = areaSum[i] + s * t;
+        heightSum[i + 1] = heightSum[i] + (t > W ? t : s);
+        // most free area that can sit beside the module in its strip
+        residSum[i + 1] = residSum[i] + std::max(0LL, W - s) * t;
+    }
+
+    // first index with short side >= v
+    auto lower = [&](long long v) {
+        return int(std::lower_bound(sides.begin(), sides.end(), std::make_pair(v, std::numeric_limits<long long>::min())) - sides.begin());
+    };
+
+    // modules wider than W/2 in any orientation never share a row, so they stack
+    int wide = lower(W / 2 + 1);
+    long long stacked = heightSum[n] - heightSum[wide];
+    mmv = stacked;
+
+    // for a threshold alpha <= W/2:
+    //   J1 short side > W - alpha: the gap beside them is narrower than alpha
+    //   J2 W/2 < short side <= W - alpha: gap beside them is at most (W - s) * t
+    //   J3 alpha <= short side <= W/2: can only go beside J2 or above/below the stack
+    // every short side up to W/2 is a candidate threshold
+    for (int i = 0; i < wide; i++)
+    {
+        long long alpha = sides[i].first;
+        if (alpha < 1 || (i > 0 && sides[i - 1].first == alpha))
+        {
+            continue;
+        }
+
+        int j3 = lower(alpha);
+        int j1 = lower(W - alpha + 1);
+
+        long long a3 = areaSum[wide] - areaSum[j3];
+        long long resid = residSum[j1] - residSum[wide];
+        long long extra = std::max(0LL, (a3 - resid + W - 1) / W);
+
+        mmv = std::max<long long>(mmv, stacked + extra);
+    }
+}
+
+double heightGap(int height, int bound)
+{
+    if (height <= 0)
+    {
+        return 0.0;
+    }
+    return std::max(0.0, double(height - bound) / height);
+}
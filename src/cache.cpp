@@ -0,0 +1,194 @@
+#include "cache.h"
+#include <atomic>
+#include <unistd.h>
+
+namespace
+{
+    const char magic[4] = {'F', 'P', 'C', '1'};
+
+    struct Fnv
+    {
+        uint64_t h = 1469598103934665603ULL;
+
+        void add(const void * data, size_t len)
+        {
+            const unsigned char * p = static_cast<const unsigned char *>(data);
+            for (size_t i = 0; i < len; i++)
+            {
+                h ^= p[i];
+                h *= 1099511628211ULL;
+            }
+        }
+
+        void add(int32_t v) { add(&v, sizeof(v)); }
+    };
+
+    template <class T>
+    void put(std::ostream &out, T v)
+    {
+        out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    template <class T>
+    bool get(std::istream &in, T &v)
+    {
+        return bool(in.read(reinterpret_cast<char *>(&v), sizeof(v)));
+    }
+}
+
+ResultCache::ResultCache(const std::string &dir, uintmax_t maxBytes) : dir_(dir), maxBytes_(maxBytes)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+}
+
+uint64_t ResultCache::key(const std::vector<Module *> &modules, const Spec &spec, const std::string &parameters)
+{
+    Fnv fnv;
+    fnv.add(int32_t(modules.size()));
+    for (auto m : modules)
+    {
+        fnv.add(int32_t(m->getId()));
+        fnv.add(int32_t(m->getOrgWidth()));
+        fnv.add(int32_t(m->getOrgHeight()));
+    }
+    fnv.add(int32_t(spec.problemType));
+    fnv.add(&spec.targetWidth, sizeof(spec.targetWidth));
+    fnv.add(&spec.targetHeight, sizeof(spec.targetHeight));
+    fnv.add(parameters.data(), parameters.size());
+    return fnv.h;
+}
+
+std::filesystem::path ResultCache::path(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.fpc", static_cast<unsigned long long>(key));
+    return dir_ / name;
+}
+
+// layout: magic, key, module count, height, bound, optimal, then x, y, rotated per module
+bool ResultCache::load(uint64_t key, size_t n, CacheEntry &entry)
+{
+    std::ifstream in(path(key), std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    char head[4];
+    uint64_t storedKey;
+    uint32_t count;
+    int32_t height, bound;
+    uint8_t optimal;
+
+    if (!in.read(head, 4) || !std::equal(head, head + 4, magic) || !get(in, storedKey) || storedKey != key ||
+        !get(in, count) || count != n || !get(in, height) || !get(in, bound) || !get(in, optimal))
+    {
+        return false;
+    }
+
+    entry.x.resize(n);
+    entry.y.resize(n);
+    entry.rotated.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        int32_t x, y;
+        uint8_t r;
+        if (!get(in, x) || !get(in, y) || !get(in, r))
+        {
+            return false;
+        }
+        entry.x[i] = x;
+        entry.y[i] = y;
+        entry.rotated[i] = r;
+    }
+    entry.height = height;
+    entry.bound = bound;
+    entry.optimal = optimal;
+
+    // most recently used
+    std::error_code ec;
+    std::filesystem::last_write_time(path(key), std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void ResultCache::store(uint64_t key, const CacheEntry &entry)
+{
+    // write to a temporary name first so a concurrent reader never sees half an entry,
+    // the name is unique per process and store so concurrent writers never share one
+    static std::atomic<unsigned> stores{0};
+    std::filesystem::path target = path(key);
+    std::filesystem::path tmp = target;
+    tmp += "." + std::to_string(getpid()) + "." + std::to_string(stores++) + ".tmp";
+
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return;
+        }
+
+        out.write(magic, 4);
+        put(out, key);
+        put(out, uint32_t(entry.x.size()));
+        put(out, int32_t(entry.height));
+        put(out, int32_t(entry.bound));
+        put(out, uint8_t(entry.optimal));
+        for (size_t i = 0; i < entry.x.size(); i++)
+        {
+            put(out, int32_t(entry.x[i]));
+            put(out, int32_t(entry.y[i]));
+            put(out, uint8_t(entry.rotated[i]));
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, target, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp, ec);
+    }
+    evict();
+}
+
+void ResultCache::evict()
+{
+    std::vector<std::tuple<std::filesystem::file_time_type, std::filesystem::path, uintmax_t>> entries;
+    uintmax_t total = 0;
+
+    // an entry another process removed meanwhile gives an error, it is skipped
+    std::error_code ec;
+    for (auto &f : std::filesystem::directory_iterator(dir_, ec))
+    {
+        if (f.path().extension() != ".fpc")
+        {
+            continue;
+        }
+        uintmax_t size = f.file_size(ec);
+        if (ec)
+        {
+            continue;
+        }
+        auto time = f.last_write_time(ec);
+        if (ec)
+        {
+            continue;
+        }
+        total += size;
+        entries.push_back({time, f.path(), size});
+    }
+
+    std::sort(entries.begin(), entries.end());
+    for (auto &[time, file, size] : entries)
+    {
+        if (total <= maxBytes_)
+        {
+            break;
+        }
+        std::filesystem::remove(file, ec);
+        if (!ec)
+        {
+            total -= size;
+        }
+    }
+}
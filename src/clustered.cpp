@@ -0,0 +1,157 @@
+#include "floorplanner.h"
+
+// clustered flow
+// modules with similar sides are grouped into clusters of groupSize, at most
+// exactSize so every cluster gets the exact search instead of an ILP, each cluster
+// is packed on its own by solveCluster into a strip about as wide as it is tall,
+// and the packed clusters then go into the outline as
+// blocks by bottom-left fill. Clusters with the same sides up to order and rotation,
+// e.g. arrays of one macro, come out of the cluster memo instead of being solved again
+float Floorplanner::clusterOpt()
+{
+    std::vector<Module *> sorted = getModules();
+    auto sides = [](const Module * m) {
+        return std::make_pair(std::max(m->getOrgWidth(), m->getOrgHeight()), std::min(m->getOrgWidth(), m->getOrgHeight()));
+    };
+    std::stable_sort(sorted.begin(), sorted.end(), [&](const Module * a, const Module * b) { return sides(a) > sides(b); });
+
+    int n = sorted.size();
+    int k = std::max(1, exactSize > 0 ? std::min(groupSize, exactSize) : groupSize);
+
+    struct Block
+    {
+        std::vector<Module *> members;      // placed relative to the block's bottom left corner
+        int w, h;
+    };
+    std::vector<Block> blocks;
+
+    for (int first = 0; first < n; first += k)
+    {
+        std::vector<Module *> group(sorted.begin() + first, sorted.begin() + std::min(n, first + k));
+
+        long area = 0;
+        int narrowest = 0;      // widest module on its short side, no strip can be narrower
+        for (auto m : group)
+        {
+            area += long(m->getOrgWidth()) * m->getOrgHeight();
+            narrowest = std::max(narrowest, std::min(m->getOrgWidth(), m->getOrgHeight()));
+        }
+
+        // a square strip and a wider one, the denser packing is kept
+        // the whole instance in one cluster is just the instance, solved at full width
+        std::vector<int> widths;
+        if (int(group.size()) == n)
+        {
+            widths.push_back(spec.targetWidth);
+        }
+        else
+        {
+            int square = int(std::ceil(std::sqrt(double(area))));
+            for (double f : {1.0, 1.5})
+            {
+                int w = std::min<int>(spec.targetWidth, std::max<int>(narrowest, std::ceil(f * square)));
+                if (std::find(widths.begin(), widths.end(), w) == widths.end())
+                {
+                    widths.push_back(w);
+                }
+            }
+        }
+
+        Block best{group, 0, 0};
+        double bestDensity = -1.0;
+        std::vector<std::pair<Point, bool>> kept;
+
+        for (int width : widths)
+        {
+            Cluster c(group);
+            if (deadline.expired() || !solveCluster(&c, width, spec.targetHeight, int((area + width - 1) / width), 0))
+            {
+                SkylinePacker packer(group, width);
+                Sequence seq = tallestFirst(packer);
+                std::vector<int> xs, ys;
+                packer.pack(seq, xs, ys);
+                packer.apply(seq, xs, ys);
+            }
+
+            int w = 0, h = 0;
+            for (auto m : group)
+            {
+                w = std::max(w, int(m->getPosition().x()) + m->getRotatedWidth());
+                h = std::max(h, int(m->getPosition().y()) + m->getRotatedHeight());
+            }
+
+            double density = double(area) / (double(w) * h);
+            if (density > bestDensity)
+            {
+                bestDensity = density;
+                best.w = w;
+                best.h = h;
+                kept.clear();
+                for (auto m : group)
+                {
+                    kept.push_back({m->getPosition(), m->isRotated()});
+                }
+            }
+        }
+
+        for (size_t i = 0; i < group.size(); i++)
+        {
+            group[i]->setRotate(kept[i].second);
+            group[i]->setPosition(kept[i].first);
+        }
+        blocks.push_back(best);
+    }
+
+    std::cout << "Clustered: " << blocks.size() << " clusters of up to " << k << " modules, "
+              << clusterMemo.size() << " placements in the memo" << std::endl;
+
+    // blocks by bottom-left fill, biggest first, each as packed or transposed,
+    // which mirrors it on the diagonal and turns every module in it
+    std::stable_sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) {
+        return long(a.w) * a.h > long(b.w) * b.h;
+    });
+
+    OccupancyGrid grid(spec.targetWidth);
+    int height = 0;
+    for (auto &b : blocks)
+    {
+        int bestX = 0, bestY = height;
+        bool bestTransposed = false;
+        int bestTop = std::numeric_limits<int>::max();
+
+        for (int t = 0; t < 2; t++)
+        {
+            int w = t ? b.h : b.w;
+            int h = t ? b.w : b.h;
+            int x, y;
+            if (grid.findLowestLeft(w, h, x, y) && (y + h < bestTop || (y + h == bestTop && y < bestY)))
+            {
+                bestX = x;
+                bestY = y;
+                bestTransposed = t;
+                bestTop = y + h;
+            }
+        }
+
+        for (auto m : b.members)
+        {
+            Point p = m->getPosition();
+            if (bestTransposed)
+            {
+                m->setRotate(!m->isRotated());
+                m->setPosition(Point(bestX + p.y(), bestY + p.x()));
+            }
+            else
+            {
+                m->setPosition(Point(bestX + p.x(), bestY + p.y()));
+            }
+        }
+
+        int w = bestTransposed ? b.h : b.w;
+        int h = bestTransposed ? b.w : b.h;
+        grid.place(bestX, bestY, w, h);
+        height = std::max(height, bestY + h);
+    }
+
+    return height;
+}
@@ -0,0 +1,116 @@
+#include "compactor.h"
+
+Compactor::Compactor(const std::vector<Module *> &modules) : modules_(modules), preds_(modules.size())
+{
+}
+
+bool Compactor::compactAxis(std::vector<int> &pos, const std::vector<int> &len, const std::vector<int> &cross, const std::vector<int> &crossLen)
+{
+    int n = pos.size();
+
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return pos[a] != pos[b] ? pos[a] < pos[b] : cross[a] < cross[b];
+    });
+
+    // sweep along the axis keeping the contour of the modules seen so far
+    // (cross coordinate where a piece starts -> module on top of it, -1 for the floor)
+    // a module only gets edges from the modules it can see on the contour,
+    // every other pair is implied through a chain of those
+    std::map<int, int> contour;
+    contour[std::numeric_limits<int>::min()] = -1;
+
+    auto split = [&](int at) {
+        auto it = std::prev(contour.upper_bound(at));
+        if (it->first != at)
+        {
+            contour.emplace_hint(std::next(it), at, it->second);
+        }
+    };
+
+    for (int i : order)
+    {
+        int a = cross[i];
+        int b = cross[i] + crossLen[i];
+
+        preds_[i].clear();
+        if (b <= a)
+        {
+            continue;
+        }
+
+        split(a);
+        split(b);
+
+        auto first = contour.find(a);
+        auto last = contour.find(b);
+        for (auto it = first; it != last; ++it)
+        {
+            int owner = it->second;
+            if (owner >= 0 && std::find(preds_[i].begin(), preds_[i].end(), owner) == preds_[i].end())
+            {
+                preds_[i].push_back(owner);
+            }
+        }
+
+        contour.erase(first, last);
+        contour[a] = i;
+    }
+
+    // longest path, the sweep order is already topological
+    bool moved = false;
+    for (int i : order)
+    {
+        int p = 0;
+        for (int j : preds_[i])
+        {
+            p = std::max(p, pos[j] + len[j]);
+        }
+
+        if (p != pos[i])
+        {
+            pos[i] = p;
+            moved = true;
+        }
+    }
+
+    return moved;
+}
+
+int Compactor::compact(const Deadline &deadline, int maxPasses)
+{
+    int n = modules_.size();
+    std::vector<int> xs(n), ys(n), ws(n), hs(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        xs[i] = std::lround(modules_[i]->getPosition().x());
+        ys[i] = std::lround(modules_[i]->getPosition().y());
+        ws[i] = modules_[i]->getRotatedWidth();
+        hs[i] = modules_[i]->getRotatedHeight();
+    }
+
+    for (int pass = 0; pass < maxPasses && (pass == 0 || !deadline.expired()); pass++)
+    {
+        bool movedY = compactAxis(ys, hs, xs, ws);
+        bool movedX = compactAxis(xs, ws, ys, hs);
+
+        if (!movedY && !movedX)
+        {
+            break;
+        }
+    }
+
+    int height = 0;
+    for (int i = 0; i < n; i++)
+    {
+        modules_[i]->setPosition(Point(xs[i], ys[i]));
+        height = std::max(height, ys[i] + hs[i]);
+    }
+
+    return height;
+}
@@ -0,0 +1,364 @@
+#include "floorplanner.h"
+
+// incremental re-floorplanning after an engineering change order (ECO)
+// the previous output is taken as the placement, the delta adds, removes or
+// resizes a few modules, every module the change leaves legal stays where it is
+// and only the disturbed ones are placed again, so the work follows the size of
+// the change instead of the size of the design
+//
+// delta file, one edit per line, # starts a comment:
+//   add <id> <w> <h>
+//   remove <id>
+//   resize <id> <w> <h>
+
+namespace
+{
+    struct Rect
+    {
+        int x, y, w, h;
+    };
+
+    // rectangles bucketed on a uniform grid, an overlap query only looks at the
+    // few buckets the query covers instead of every placed module
+    class Occupancy
+    {
+    public:
+        explicit Occupancy(int cell) : cell_(std::max(1, cell)) {}
+
+        void insert(const Rect &r)
+        {
+            int id = rects_.size();
+            rects_.push_back(r);
+            forCells(r, [&](long long key) { buckets_[key].push_back(id); return true; });
+        }
+
+        bool overlaps(const Rect &r) const
+        {
+            bool hit = false;
+            forCells(r, [&](long long key) {
+                auto it = buckets_.find(key);
+                if (it == buckets_.end())
+                {
+                    return true;
+                }
+                for (int id : it->second)
+                {
+                    const Rect &o = rects_[id];
+                    if (r.x < o.x + o.w && o.x < r.x + r.w && r.y < o.y + o.h && o.y < r.y + r.h)
+                    {
+                        hit = true;
+                        return false;
+                    }
+                }
+                return true;
+            });
+            return hit;
+        }
+
+        const std::vector<Rect> &rects() const { return rects_; }
+
+    private:
+        // f(key) for every bucket r touches, stops early when f returns false
+        template <class F>
+        void forCells(const Rect &r, F f) const
+        {
+            for (int cy = r.y / cell_; cy <= (r.y + r.h - 1) / cell_; cy++)
+            {
+                for (int cx = r.x / cell_; cx <= (r.x + r.w - 1) / cell_; cx++)
+                {
+                    if (!f((long long)cy << 32 | (unsigned)cx))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+
+        int cell_;
+        std::vector<Rect> rects_;
+        std::unordered_map<long long, std::vector<int>> buckets_;
+    };
+
+    Rect footprint(const Module * m)
+    {
+        return {int(m->getPosition().x()), int(m->getPosition().y()), m->getRotatedWidth(), m->getRotatedHeight()};
+    }
+}
+
+bool Floorplanner::applyEco(const std::string &previousOutput, const std::string &deltaFile)
+{
+    ScopedPhase phase("eco");
+
+    std::ifstream previous(previousOutput);
+    std::ifstream delta(deltaFile);
+    if (!previous || !delta)
+    {
+        std::cout << "ECO: cannot open " << (!previous ? previousOutput : deltaFile) << std::endl;
+        return false;
+    }
+
+    // previous placement by module id
+    std::unordered_map<int, std::pair<Point, bool>> placed;
+    int id, x, y, r;
+    while (previous >> id >> x >> y >> r)
+    {
+        placed[id] = {Point(x, y), r != 0};
+    }
+
+    std::unordered_map<int, size_t> index;
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        index[modules[i]->getId()] = i;
+    }
+
+    // edits, resized and added modules are the ones that may have to move
+    // the delta is checked whole before the instance changes
+    std::unordered_set<int> resized, removed;
+    std::vector<std::unique_ptr<Module>> added;
+    std::vector<std::tuple<int, int, int>> resizes;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(delta, line))
+    {
+        lineNo++;
+        std::istringstream in(line.substr(0, line.find('#')));
+        std::string op;
+        if (!(in >> op))
+        {
+            continue;
+        }
+
+        int w = 0, h = 0;
+        bool ok = bool(in >> id);
+        if (op == "add" || op == "resize")
+        {
+            ok = ok && (in >> w >> h) && w > 0 && h > 0;
+        }
+
+        // ids are never reused within one delta, not even after a remove
+        bool exists = index.count(id) > 0;
+        bool live = exists && !removed.count(id);
+        if (!ok || (op == "add" && exists) || (op != "add" && !live) || (op != "add" && op != "remove" && op != "resize"))
+        {
+            std::cout << "ECO: bad edit on line " << lineNo << " of " << deltaFile << ": " << line << std::endl;
+            return false;
+        }
+
+        if (op == "add")
+        {
+            index[id] = modules.size() + added.size();
+            added.push_back(std::unique_ptr<Module>(new Module(id, w, h)));
+            placed.erase(id);
+        }
+        else if (op == "remove")
+        {
+            removed.insert(id);
+            resized.erase(id);
+        }
+        else
+        {
+            resizes.push_back({id, w, h});
+            resized.insert(id);
+        }
+    }
+
+    // the watchdog writes the incumbent against the module list, neither may change under it
+    int addedCount = added.size();
+    {
+        std::lock_guard<std::mutex> lock(incumbentMutex);
+        for (auto &m : added)
+        {
+            modules.push_back(std::move(m));
+        }
+        for (auto &[rid, w, h] : resizes)
+        {
+            modules[index[rid]]->setWidth(w);
+            modules[index[rid]]->setHeight(h);
+        }
+        if (!removed.empty())
+        {
+            modules.erase(std::remove_if(modules.begin(), modules.end(), [&](const std::unique_ptr<Module> &m) {
+                return removed.count(m->getId()) > 0;
+            }), modules.end());
+        }
+        incumbent = Incumbent();
+    }
+    heightBound = -1;
+
+    // unchanged modules claim their old spots first, then resized ones in either
+    // orientation, anything out of the outline or overlapping a claimed spot floats
+    // buckets about the size of an average module
+    long sides = 0;
+    for (auto &m : modules)
+    {
+        sides += std::max(m->getOrgWidth(), m->getOrgHeight());
+    }
+    Occupancy occupancy(modules.empty() ? 1 : int(sides / long(modules.size())));
+
+    auto fits = [&](const Rect &r) {
+        return r.x >= 0 && r.y >= 0 && r.x + r.w <= spec.targetWidth && r.y + r.h <= spec.targetHeight && !occupancy.overlaps(r);
+    };
+
+    std::vector<Module *> floating;
+    std::vector<Module *> order;
+    for (auto &m : modules)
+    {
+        if (!resized.count(m->getId()))
+        {
+            order.push_back(m.get());
+        }
+    }
+    for (auto &m : modules)
+    {
+        if (resized.count(m->getId()))
+        {
+            order.push_back(m.get());
+        }
+    }
+
+    int fixedTop = 0;
+    for (auto m : order)
+    {
+        auto it = placed.find(m->getId());
+        if (it == placed.end())
+        {
+            floating.push_back(m);
+            continue;
+        }
+
+        m->setPosition(it->second.first);
+        m->setRotate(it->second.second);
+        if (!fits(footprint(m)))
+        {
+            m->rotate();
+        }
+        if (!fits(footprint(m)))
+        {
+            m->setRotate(it->second.second);
+            floating.push_back(m);
+            continue;
+        }
+
+        occupancy.insert(footprint(m));
+        fixedTop = std::max(fixedTop, int(m->getPosition().y()) + m->getRotatedHeight());
+    }
+
+    int kept = modules.size() - floating.size();
+    std::cout << "ECO: " << addedCount << " added, " << removed.size() << " removed, " << resized.size() << " resized, "
+              << kept << " modules kept in place, " << floating.size() << " to place" << std::endl;
+    countEvent("eco.floating", floating.size());
+
+    // greedy insertion, biggest first, at the corner point that raises the height
+    // the least, ties go to the spot closest to where the module used to be
+    std::stable_sort(floating.begin(), floating.end(), [](Module * a, Module * b) {
+        return a->getOrgWidth() * a->getOrgHeight() > b->getOrgWidth() * b->getOrgHeight();
+    });
+
+    int top = fixedTop;
+    for (auto m : floating)
+    {
+        auto it = placed.find(m->getId());
+        Point anchor = it != placed.end() ? it->second.first : Point(0, 0);
+
+        std::vector<std::pair<int, int>> corners = {{0, 0}, {0, top}};
+        for (const Rect &o : occupancy.rects())
+        {
+            corners.push_back({o.x + o.w, o.y});
+            corners.push_back({o.x, o.y + o.h});
+            corners.push_back({0, o.y + o.h});
+        }
+
+        bool found = false;
+        Rect best{0, 0, 0, 0};
+        std::pair<int, double> bestCost;
+        for (int turn = 0; turn < 2; turn++)
+        {
+            int w = turn ? m->getOrgHeight() : m->getOrgWidth();
+            int h = turn ? m->getOrgWidth() : m->getOrgHeight();
+            for (auto &[cx, cy] : corners)
+            {
+                Rect c{cx, cy, w, h};
+                if (!fits(c))
+                {
+                    continue;
+                }
+                std::pair<int, double> cost = {std::max(top, cy + h), std::hypot(cx - anchor.x(), cy - anchor.y())};
+                if (!found || cost < bestCost)
+                {
+                    found = true;
+                    best = c;
+                    bestCost = cost;
+                }
+            }
+        }
+
+        // {0, top} is above everything, if even that is out of the outline nothing is left
+        if (!found)
+        {
+            std::cout << "ECO: module " << m->getId() << " fits nowhere inside the outline" << std::endl;
+            return false;
+        }
+
+        m->setRotate(best.w != m->getOrgWidth());
+        m->setPosition(Point(best.x, best.y));
+        occupancy.insert(best);
+        top = std::max(top, best.y + best.h);
+    }
+
+    std::cout << "ECO: insertion height " << top << " (kept modules reach " << fixedTop << ")" << std::endl;
+
+    // the inserted modules are re-solved exactly in windows against everything else,
+    // only the part above the kept modules counts, see augmentOpt()
+    std::sort(floating.begin(), floating.end(), [](Module * a, Module * b) {
+        return a->getPosition().y() < b->getPosition().y();
+    });
+
+    int k = std::max(1, windowSize);
+    for (size_t first = 0; first < floating.size() && windowTime > 0 && !deadline.expired(); first += k)
+    {
+        std::vector<Module *> window(floating.begin() + first, floating.begin() + std::min(floating.size(), first + k));
+        std::unordered_set<Module *> inWindow(window.begin(), window.end());
+
+        int yLow = std::numeric_limits<int>::max();
+        int yHigh = 0;
+        int tallest = 0;
+        for (auto m : window)
+        {
+            yLow = std::min(yLow, int(m->getPosition().y()));
+            yHigh = std::max(yHigh, int(m->getPosition().y()) + m->getRotatedHeight());
+            tallest = std::max(tallest, std::max(m->getOrgWidth(), m->getOrgHeight()));
+        }
+        yLow = std::max(0, yLow - tallest);
+
+        std::vector<Obstacle> obstacles;
+        for (auto &m : modules)
+        {
+            double my = m->getPosition().y();
+            if (inWindow.count(m.get()) || my >= yHigh || my + m->getRotatedHeight() <= yLow)
+            {
+                continue;
+            }
+            obstacles.push_back({m->getPosition().x(), my, double(m->getRotatedWidth()), double(m->getRotatedHeight())});
+        }
+
+        std::vector<std::pair<Point, bool>> saved;
+        for (auto m : window)
+        {
+            saved.push_back({m->getPosition(), m->isRotated()});
+        }
+
+        int before = getHeight();
+        if (solveWindow(window, obstacles, yLow, yHigh, deadline.limit(windowTime), fixedTop) && (getHeight() > before || !isLegal()))
+        {
+            for (size_t i = 0; i < window.size(); i++)
+            {
+                window[i]->setRotate(saved[i].second);
+                window[i]->setPosition(saved[i].first);
+            }
+        }
+    }
+
+    std::cout << "ECO: height " << getHeight() << std::endl;
+    saveIncumbent();
+    return true;
+}
@@ -0,0 +1,23 @@
+#include "formulation.h"
+
+// naming of the encodings, kept apart from the model building so the option
+// parsing and the cache key do not pull in Gurobi
+bool parseEncoding(const std::string &name, Encoding &encoding)
+{
+    if (name == "bigm")
+    {
+        encoding = Encoding::BigM;
+        return true;
+    }
+    if (name == "indicator")
+    {
+        encoding = Encoding::Indicator;
+        return true;
+    }
+    return false;
+}
+
+const char * encodingName(Encoding encoding)
+{
+    return encoding == Encoding::Indicator ? "indicator" : "bigm";
+}
@@ -0,0 +1,317 @@
+#include "exact.h"
+#include <array>
+#include <cstring>
+
+// branch and bound over corner points (Martello and Vigo)
+// placed modules are summarised by their envelope, the staircase under which
+// nothing can go any more: at x its height is the highest top of a placed module
+// reaching past x. A new module only ever goes on a corner of the staircase, which
+// still reaches every bottom-left justified packing. The envelope and the set of
+// placed modules are all the remaining search depends on, so revisits are cut,
+// and the area under the envelope plus the area still to place bounds the height.
+//
+// N is fixed at compile time so every per node array lives on the stack and the
+// placed set is a bitmask, packExact() picks the instantiation for the cluster
+
+namespace
+{
+    template <int N>
+    class ExactPacker
+    {
+    public:
+        using Mask = uint32_t;
+        static constexpr Mask all = (Mask(1) << N) - 1;
+
+        ExactPacker(const std::vector<Module *> &modules, int targetWidth, int limit, int lowerBound, const Deadline &deadline)
+            : width_(targetWidth), best_(limit), lowerBound_(lowerBound), deadline_(deadline)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                w_[i] = modules[i]->getOrgWidth();
+                h_[i] = modules[i]->getOrgHeight();
+                order_[i] = i;
+            }
+
+            // big modules first, they decide the most and fail the soonest
+            std::stable_sort(order_.begin(), order_.end(), [&](int a, int b) { return w_[a] * h_[a] > w_[b] * h_[b]; });
+
+            // modules with the same sides are interchangeable, the later one waits for the earlier
+            for (int k = 0; k < N; k++)
+            {
+                int i = order_[k];
+                twin_[i] = -1;
+                for (int j = k - 1; j >= 0 && twin_[i] < 0; j--)
+                {
+                    int o = order_[j];
+                    if (std::min(w_[i], h_[i]) == std::min(w_[o], h_[o]) && std::max(w_[i], h_[i]) == std::max(w_[o], h_[o]))
+                    {
+                        twin_[i] = o;
+                    }
+                }
+            }
+        }
+
+        ExactStatus solve(ExactPlacement &out)
+        {
+            long area = 0;
+            for (int i = 0; i < N; i++)
+            {
+                area += long(w_[i]) * h_[i];
+            }
+
+            Envelope start;
+            start.x[0] = 0;
+            start.y[0] = 0;
+            start.size = 1;
+            search(0, start, 0, area);
+
+            out.nodes = nodes_;
+            if (found_)
+            {
+                out.x.assign(bestX_.begin(), bestX_.end());
+                out.y.assign(bestY_.begin(), bestY_.end());
+                out.rotated.assign(bestR_.begin(), bestR_.end());
+                out.height = best_;
+            }
+
+            if (aborted_)
+            {
+                return ExactStatus::Aborted;
+            }
+            return found_ ? ExactStatus::Optimal : ExactStatus::NoneBelow;
+        }
+
+    private:
+        // steps of the staircase left to right, step k covers [x[k], x[k + 1]) at
+        // height y[k], heights strictly decrease, every placement adds at most one step
+        struct Envelope
+        {
+            std::array<int, N + 1> x, y;
+            int size;
+        };
+
+        void search(Mask placed, const Envelope &env, long envArea, long remainingArea)
+        {
+            if (++nodes_ >= exactNodeLimit || ((nodes_ & 1023) == 0 && deadline_.expired()))
+            {
+                aborted_ = true;
+            }
+            if (aborted_ || done_)
+            {
+                return;
+            }
+
+            if (placed == all)
+            {
+                // the leftmost step is the highest top
+                best_ = env.y[0];
+                bestX_ = x_;
+                bestY_ = y_;
+                bestR_ = r_;
+                found_ = true;
+                done_ = best_ <= lowerBound_;
+                return;
+            }
+
+            long areaBound = (envArea + remainingArea + width_ - 1) / width_;
+            if (std::max<long>(env.y[0], areaBound) >= best_ || unplaceable(placed, env) || !visit(placed, env))
+            {
+                return;
+            }
+
+            for (int k = 0; k < N; k++)
+            {
+                int i = order_[k];
+                if ((placed >> i & 1) || (twin_[i] >= 0 && !(placed >> twin_[i] & 1)))
+                {
+                    continue;
+                }
+
+                for (int r = 0; r < 2; r++)
+                {
+                    if (r && w_[i] == h_[i])
+                    {
+                        break;
+                    }
+                    int w = r ? h_[i] : w_[i];
+                    int h = r ? w_[i] : h_[i];
+
+                    // lowest corners first, they find low packings early
+                    for (int s = env.size - 1; s >= 0; s--)
+                    {
+                        int cx = env.x[s];
+                        int cy = env.y[s];
+                        if (cx + w > width_ || cy + h >= best_)
+                        {
+                            continue;
+                        }
+
+                        Envelope next;
+                        long nextArea = raise(env, cx + w, cy + h, next);
+
+                        x_[i] = cx;
+                        y_[i] = cy;
+                        r_[i] = r;
+                        search(placed | Mask(1) << i, next, nextArea, remainingArea - long(w) * h);
+                        if (aborted_ || done_)
+                        {
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+
+        // envelope after a module with its top right corner at (right, top) went in,
+        // everything left of right is at least top now, returns the area under it
+        long raise(const Envelope &env, int right, int top, Envelope &next) const
+        {
+            next.size = 0;
+            auto push = [&](int sx, int sy) {
+                if (next.size == 0 || next.y[next.size - 1] != sy)
+                {
+                    next.x[next.size] = sx;
+                    next.y[next.size] = sy;
+                    next.size++;
+                }
+            };
+
+            for (int s = 0; s < env.size; s++)
+            {
+                int end = s + 1 < env.size ? env.x[s + 1] : width_;
+                if (end <= right)
+                {
+                    push(env.x[s], std::max(env.y[s], top));
+                }
+                else if (env.x[s] >= right)
+                {
+                    push(env.x[s], env.y[s]);
+                }
+                else
+                {
+                    push(env.x[s], std::max(env.y[s], top));
+                    push(right, env.y[s]);
+                }
+            }
+
+            long area = 0;
+            for (int s = 0; s < next.size; s++)
+            {
+                int end = s + 1 < next.size ? next.x[s + 1] : width_;
+                area += long(end - next.x[s]) * next.y[s];
+            }
+            return area;
+        }
+
+        // true if some module left cannot go anywhere below best_, the envelope never
+        // sinks and falls to the right, so the rightmost spot is the lowest one it gets
+        bool unplaceable(Mask placed, const Envelope &env) const
+        {
+            for (int i = 0; i < N; i++)
+            {
+                if (placed >> i & 1)
+                {
+                    continue;
+                }
+
+                int lowest = std::numeric_limits<int>::max();
+                for (int r = 0; r < 2; r++)
+                {
+                    int w = r ? h_[i] : w_[i];
+                    int h = r ? w_[i] : h_[i];
+                    if (w <= width_)
+                    {
+                        lowest = std::min(lowest, at(env, width_ - w) + h);
+                    }
+                }
+                if (lowest >= best_)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // envelope height at x
+        static int at(const Envelope &env, int x)
+        {
+            int s = env.size - 1;
+            while (env.x[s] > x)
+            {
+                s--;
+            }
+            return env.y[s];
+        }
+
+        // true the first time a state is seen, the table stops growing at a fixed size
+        bool visit(Mask placed, const Envelope &env)
+        {
+            if (visited_.size() >= (1u << 19))
+            {
+                return true;
+            }
+
+            std::string key(sizeof(Mask) + 2 * sizeof(int) * env.size, '\0');
+            std::memcpy(&key[0], &placed, sizeof(Mask));
+            std::memcpy(&key[sizeof(Mask)], env.x.data(), sizeof(int) * env.size);
+            std::memcpy(&key[sizeof(Mask) + sizeof(int) * env.size], env.y.data(), sizeof(int) * env.size);
+            return visited_.insert(std::move(key)).second;
+        }
+
+        std::array<int, N> w_, h_, order_, twin_;
+        std::array<int, N> x_{}, y_{}, bestX_{}, bestY_{};
+        std::array<char, N> r_{}, bestR_{};
+        int width_;
+        int best_;          // only packings strictly below this are searched for
+        int lowerBound_;
+        const Deadline &deadline_;
+        std::unordered_set<std::string> visited_;
+        long nodes_ = 0;
+        bool found_ = false;
+        bool done_ = false;
+        bool aborted_ = false;
+    };
+
+    using Packer = ExactStatus (*)(const std::vector<Module *> &, int, int, int, const Deadline &, ExactPlacement &);
+
+    template <int N>
+    ExactStatus pack(const std::vector<Module *> &modules, int targetWidth, int limit, int lowerBound, const Deadline &deadline, ExactPlacement &out)
+    {
+        return ExactPacker<N>(modules, targetWidth, limit, lowerBound, deadline).solve(out);
+    }
+
+    // packers[n - 1] handles n modules
+    template <size_t... I>
+    constexpr std::array<Packer, sizeof...(I)> packerTable(std::index_sequence<I...>)
+    {
+        return {&pack<int(I) + 1>...};
+    }
+
+    constexpr auto packers = packerTable(std::make_index_sequence<exactMaxModules>());
+}
+
+ExactStatus packExact(const std::vector<Module *> &modules, int targetWidth, int limit, int lowerBound, const Deadline &deadline, ExactPlacement &out)
+{
+    out = ExactPlacement();
+    int n = modules.size();
+
+    if (n == 0)
+    {
+        return limit > 0 ? ExactStatus::Optimal : ExactStatus::NoneBelow;
+    }
+    if (n > exactMaxModules)
+    {
+        return ExactStatus::Aborted;
+    }
+
+    // a module wider than the outline either way round never fits
+    for (auto m : modules)
+    {
+        if (std::min(m->getOrgWidth(), m->getOrgHeight()) > targetWidth)
+        {
+            return ExactStatus::NoneBelow;
+        }
+    }
+
+    return packers[n - 1](modules, targetWidth, limit, lowerBound, deadline, out);
+}
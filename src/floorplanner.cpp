@@ -5,34 +5,150 @@
 
 void Floorplanner::solve() 
 {
-    if (spec.problemType == 0) 
+    ScopedPhase phase("solve");
+
+    // with a budget get a legal floorplan on the table first,
+    // the skyline packing takes milliseconds even on large inputs
+    if (!deadline.isUnlimited())
+    {
+        skylineOpt();
+        Compactor(getModules()).compact(deadline);
+        saveIncumbent();
+    }
+
+    // one trace/profile phase per strategy, named after the one that actually runs
+    std::string running = !strategy.empty() ? strategy : spec.problemType == 0 ? "ilp" : "shelf";
+    ScopedPhase strategyPhase(internName("strategy." + running));
+
+    if (strategy == "ilp" || (strategy.empty() && spec.problemType == 0)) 
     {
         category0Opt();
     } 
+    else if (strategy == "skyline")
+    {
+        skylineOpt();
+    }
+    else if (strategy == "blf")
+    {
+        blfOpt();
+    }
+    else if (strategy == "anneal")
+    {
+        annealOpt();
+    }
+    else if (strategy == "tempering")
+    {
+        temperingOpt();
+    }
+    else if (strategy == "lns")
+    {
+        lnsOpt();
+    }
+    else if (strategy == "portfolio")
+    {
+        portfolioOpt();
+    }
+    else if (strategy == "bisect")
+    {
+        category0Bisect();
+    }
+    else if (strategy == "augment")
+    {
+        augmentOpt();
+    }
+    else if (strategy == "cluster")
+    {
+        clusterOpt();
+    }
     else 
     {
+        if (!strategy.empty() && strategy != "shelf")
+        {
+            std::cerr << "Unknown strategy " << strategy << ", using shelf packing" << std::endl;
+        }
         category1Opt();
     }
+
+    if (compaction)
+    {
+        ScopedPhase compactPhase("compact");
+        compact();
+    }
+
+    // fall back to the best legal placement if the strategy ran out of time
+    saveIncumbent();
+    restoreIncumbent();
+
+    int height = getHeight();
+    int bound = getLowerBound();
+    if (height <= bound && isLegal())
+    {
+        provenOptimal = true;
+    }
+    std::cout << "Height " << height << ", lower bound " << bound << ", gap " << 100.0 * heightGap(height, bound) << "%" << std::endl;
 }
 
-// Implement the ILP model to minimize height here
-// Use the solver_ object to add variables, constraints, and set the objective
-// After setting up the model, call solver_.optimize() to solve it
-// Update the positions and rotations of modules based on the solution
+Solver &Floorplanner::solver()
+{
+    std::lock_guard<std::mutex> lock(solverMutex);
+    if (!solver_)
+    {
+        solver_ = std::make_shared<Solver>();
+        solver_->setLogging(logFile, logConsole);
+        if (telemetry)
+        {
+            solver_->setTelemetry(true, telemetry);
+        }
+
+        // a cancel() that came first could not reach it
+        if (deadline.expired())
+        {
+            solver_->terminate();
+        }
+    }
+    return *solver_;
+}
 
-bool Floorplanner::solveCluster(Cluster * c, float targetWidth, float targetHeight) 
+// drop the model solveWindow keeps before a different one is built
+void Floorplanner::releaseWindow()
 {
-    std::vector<Module *> clusterModules = c->getSubModules();
+    if (windowModules >= 0)
+    {
+        solver().reset();
+        windowModules = -1;
+        windowObstacles = 0;
+    }
+}
 
-    // reset modules because weird shit happening
-    for (auto m : clusterModules)
+// make the running strategy give up, callable from any thread
+void Floorplanner::cancel()
+{
+    deadline.cancel();
+
+    std::lock_guard<std::mutex> lock(solverMutex);
+    if (solver_)
     {
-        m->setRotate(false);
-        m->setPosition(Point(0, 0));
+        solver_->terminate();
     }
+}
+
+// Implement the ILP model to minimize height here
+// Use the solver() object to add variables, constraints, and set the objective
+// After setting up the model, call solver().optimize() to solve it
+// Update the positions and rotations of modules based on the solution
+
+// monolithic model over the given modules: x/y/r per module, one p/q pair per module
+// pair and the height variable "Y" in [lowerBound, targetHeight], no objective
+// returns no variables if the deadline expired while building
+std::vector<ModuleVars> Floorplanner::buildModel(const std::vector<Module *> &clusterModules, float targetWidth, float targetHeight, int lowerBound)
+{
+    ScopedPhase phase("buildModel");
+
+    releaseWindow();
 
     int n = clusterModules.size();
     double M = std::max(targetWidth, targetHeight);
+    Formulation formulation(solver(), M, encoding);
 
     // create variables for each module
     //
@@ -40,118 +156,392 @@ bool Floorplanner::solveCluster(Cluster * c, float targetWidth, float targetHeig
     // x left coordinate
     // y bottom coordinate
     // r rotation flag
-    std::vector<std::string> x_vars(n), y_vars(n), r_vars(n);
+    std::vector<ModuleVars> vars(n);
 
-    for (int i = 0; i < n; i++)
     {
-        x_vars[i] = "x_" + std::to_string(i);
-        y_vars[i] = "y_" + std::to_string(i);
-        r_vars[i] = "r_" + std::to_string(i);
+        ScopedPhase phase("build.variables");
+        for (int i = 0; i < n; i++)
+        {
+            Module * mod_i = clusterModules[i];
+            vars[i] = formulation.addModule(std::to_string(i), mod_i->getOrgWidth(), mod_i->getOrgHeight(), targetWidth, 0.0, targetHeight);
+        }
 
-        solver_.addVariable(x_vars[i], 0.0, targetWidth, GRB_CONTINUOUS);
-        solver_.addVariable(y_vars[i], 0.0, targetHeight, GRB_CONTINUOUS);
-        solver_.addVariable(r_vars[i], 0.0, 1.0, GRB_BINARY);
+        // create variable for overall height, it can never go below the lower bound
+        solver().addVariable("Y", std::min<double>(lowerBound, targetHeight), targetHeight, GRB_CONTINUOUS);
+        countEvent("variables.module", n);
     }
 
-    // create non-overlapping variables between modules
+    // add constraints for each module, one family at a time
     //
 
-    std::vector<std::vector<std::string>> p_vars(n, std::vector<std::string>(n)); // non-overlapping flag x
-    std::vector<std::vector<std::string>> q_vars(n, std::vector<std::string>(n)); // non-overlapping flag y
+    {
+        // inside outline constraints
+        ScopedPhase phase("build.outline");
+        for (int i = 0; i < n; i++)
+        {
+            formulation.addOutline(vars[i], std::to_string(i), targetWidth, "Y");
+        }
+        countEvent("constraints.outline", n);
+    }
+
+    {
+        ScopedPhase phase("build.nonoverlap");
+        for (int i = 0; i < n; i++)
+        {
+            // the O(n^2) build alone can outlast the budget on big instances
+            if (deadline.expired())
+            {
+                std::cout << "Time budget expired while building the ILP" << std::endl;
+                return {};
+            }
+
+            // non-overlapping constraints, p/q flags pick the relative position
+            for (int j = i + 1; j < n; j++)
+            {
+                formulation.addNonOverlap(vars[i], vars[j], std::to_string(i) + "_" + std::to_string(j));
+            }
+            countEvent("constraints.nonoverlap", n - 1 - i);
+        }
+    }
+
+    return vars;
+}
+
+// branching order and hints for a model built over list
+// the binaries of big modules are decided first: a module's rotation flag gets its
+// area rank, a pair gets the rank of its smaller module, so pairs of two big modules
+// come before anything involving a small one. With hint set the current placement
+// of list, which must be legal, hints every flag with the same priority
+void Floorplanner::guideModel(const std::vector<Module *> &list, const std::vector<ModuleVars> &vars, bool hint)
+{
+    int n = list.size();
+
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return list[a]->getOrgWidth() * list[a]->getOrgHeight() > list[b]->getOrgWidth() * list[b]->getOrgHeight();
+    });
+
+    std::vector<int> priority(n);
+    for (int r = 0; r < n; r++)
+    {
+        priority[order[r]] = n - r;
+    }
+
+    std::vector<Obstacle> rects(n);
+    for (int i = 0; i < n; i++)
+    {
+        rects[i] = {list[i]->getPosition().x(), list[i]->getPosition().y(), double(list[i]->getRotatedWidth()), double(list[i]->getRotatedHeight())};
+    }
+
+    // only touches variables that already exist, the big-M is not needed
+    Formulation formulation(solver(), 0.0, encoding);
 
     for (int i = 0; i < n; i++)
     {
+        formulation.prioritize(vars[i], priority[i]);
+        if (hint)
+        {
+            formulation.hintRotation(vars[i], list[i]->isRotated(), priority[i]);
+        }
+
         for (int j = i + 1; j < n; j++)
         {
-            p_vars[i][j] = "p_" + std::to_string(i) + "_" + std::to_string(j);
-            q_vars[i][j] = "q_" + std::to_string(i) + "_" + std::to_string(j);
+            std::string tag = std::to_string(i) + "_" + std::to_string(j);
+            int p = std::min(priority[i], priority[j]);
+            formulation.prioritizePair(tag, p);
+            if (hint)
+            {
+                formulation.hintPair(tag, relation(rects[i], rects[j]), p);
+            }
+        }
+    }
+}
 
-            solver_.addVariable(p_vars[i][j], 0.0, 1.0, GRB_BINARY);
-            solver_.addVariable(q_vars[i][j], 0.0, 1.0, GRB_BINARY);
+namespace
+{
+    // modules sorted by (short side, long side), equal ones keep their cluster order
+    std::vector<Module *> canonicalOrder(std::vector<Module *> list)
+    {
+        auto sides = [](const Module * m) {
+            return std::make_pair(std::min(m->getOrgWidth(), m->getOrgHeight()), std::max(m->getOrgWidth(), m->getOrgHeight()));
+        };
+        std::stable_sort(list.begin(), list.end(), [&](const Module * a, const Module * b) { return sides(a) < sides(b); });
+        return list;
+    }
+
+    // the outline, then the sides of every module in canonical order, so clusters that
+    // only differ by permutation and rotation of their modules share a key
+    std::vector<int> memoKey(const std::vector<Module *> &order, float targetWidth, float targetHeight)
+    {
+        std::vector<int> key = {int(std::ceil(targetWidth)), int(std::ceil(targetHeight))};
+        for (auto m : order)
+        {
+            key.push_back(std::min(m->getOrgWidth(), m->getOrgHeight()));
+            key.push_back(std::max(m->getOrgWidth(), m->getOrgHeight()));
         }
+        return key;
     }
+}
 
-    // create variable for overall height
-    solver_.addVariable("Y", 0.0, targetHeight, GRB_CONTINUOUS);
-    
-    // set objective to minimize 'M' height
-    solver_.setObjective({{"Y", 1.0}}, 'M');
+bool Floorplanner::solveCluster(Cluster * c, float targetWidth, float targetHeight, int lowerBound, int upperBound) 
+{
+    ScopedPhase phase("solveCluster");
+    std::vector<Module *> clusterModules = c->getSubModules();
 
-    // add constraints for each module
-    //
+    int n = clusterModules.size();
+    bool whole = clusterModules.size() == modules.size();
+
+    // a cluster with the same sides up to order and rotation was already solved to
+    // optimality, map its placement slot by slot instead of asking Gurobi again
+    std::vector<Module *> order = canonicalOrder(clusterModules);
+    std::vector<int> key = memoKey(order, targetWidth, targetHeight);
+    auto hit = clusterMemo.find(key);
+    if (hit != clusterMemo.end())
+    {
+        const ClusterMemo &memo = hit->second;
+        countEvent("solveCluster.memoHit");
+        std::cout << "Cluster memo hit, height " << memo.height << ", ILP skipped" << std::endl;
+        provenOptimal = provenOptimal || whole;
 
-    for (int i = 0; i < n; i++)
+        // same answer the cutoff would give
+        if (upperBound > 0 && memo.height >= upperBound)
+        {
+            return false;
+        }
+
+        for (int k = 0; k < n; k++)
+        {
+            Module * m = order[k];
+            int width = memo.lying[k] ? std::max(m->getOrgWidth(), m->getOrgHeight()) : std::min(m->getOrgWidth(), m->getOrgHeight());
+            m->setRotate(m->getOrgWidth() != width);
+            m->setPosition(Point(memo.x[k], memo.y[k]));
+        }
+        return true;
+    }
+
+    // only optimal placements are remembered, a time limited one could still improve
+    auto remember = [&](int height) {
+        ClusterMemo memo;
+        for (auto m : order)
+        {
+            memo.x.push_back(int(m->getPosition().x()));
+            memo.y.push_back(int(m->getPosition().y()));
+            memo.lying.push_back(m->getRotatedWidth() > m->getRotatedHeight());
+        }
+        memo.height = height;
+        clusterMemo[key] = std::move(memo);
+    };
+
+    // the model is built around the modules, a failed solve puts them back where they were
+    std::vector<std::pair<Point, bool>> saved;
+    for (auto m : clusterModules)
     {
-        Module * mod_i = clusterModules[i];
-        double w_i = mod_i->getRotatedWidth();
-        double h_i = mod_i->getRotatedHeight();
+        saved.push_back({m->getPosition(), m->isRotated()});
+    }
+    auto restore = [&]() {
+        for (int i = 0; i < n; i++)
+        {
+            clusterModules[i]->setRotate(saved[i].second);
+            clusterModules[i]->setPosition(saved[i].first);
+        }
+    };
 
-        // inside outline constraints
-        //
+    // best packing of an aborted exact search, it bounds the ILP and is the answer if the ILP has none
+    ExactPlacement fallback;
+    auto applyFallback = [&]() {
+        for (int i = 0; i < n; i++)
+        {
+            clusterModules[i]->setRotate(fallback.rotated[i]);
+            clusterModules[i]->setPosition(Point(fallback.x[i], fallback.y[i]));
+        }
+    };
 
-        // x_i >= 0 and y_i >= 0 are already handled by variable domain
+    // tiny clusters are searched exhaustively, cheaper than building any model
+    if (n <= exactSize)
+    {
+        ScopedPhase exactPhase("exact");
+        auto exactStart = std::chrono::steady_clock::now();
+
+        // heights are integers, below the cutoff and inside the outline
+        int limit = int(std::floor(targetHeight)) + 1;
+        if (upperBound > 0)
+        {
+            limit = std::min(limit, upperBound);
+        }
 
-        solver_.addConstraint("inside_outline_x" + std::to_string(i), {{x_vars[i], 1.0}, {r_vars[i], h_i - w_i}}, '<', targetWidth - w_i);
-        solver_.addConstraint("inside_outline_y" + std::to_string(i), {{y_vars[i], 1.0}, {r_vars[i], w_i - h_i}, {"Y", -1.0}}, '<', -h_i);
+        ExactPlacement placement;
+        ExactStatus status = packExact(clusterModules, int(targetWidth), limit, lowerBound, deadline, placement);
+        countEvent("exact.nodes", placement.nodes);
 
-        // non-overlapping constraints
-        for (int j = i + 1; j < n; j++)
+        std::cout << "Exact search of " << n << " modules: " << placement.nodes << " nodes, "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - exactStart).count() << " ms" << std::endl;
+
+        if (status == ExactStatus::NoneBelow)
         {
-            Module * mod_j = clusterModules[j];
-            double w_j = mod_j->getRotatedWidth();
-            double h_j = mod_j->getRotatedHeight();
+            std::cout << "Nothing lower than " << limit << " exists" << std::endl;
+            provenOptimal = provenOptimal || whole;
+            return false;
+        }
+
+        if (status == ExactStatus::Optimal)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                clusterModules[i]->setRotate(placement.rotated[i]);
+                clusterModules[i]->setPosition(Point(placement.x[i], placement.y[i]));
+            }
+            provenOptimal = provenOptimal || whole;
+            remember(placement.height);
+            return true;
+        }
 
-            solver_.addConstraint("left_" + std::to_string(i) + "_" + std::to_string(j), 
-                {{x_vars[i], 1.0}, {x_vars[j], -1.0}, {r_vars[i], h_i - w_i}, {p_vars[i][j], -M}, {q_vars[i][j], -M}}, '<', -w_i);
+        // out of time or nodes, fall through so the ILP decides with whatever is left,
+        // starting from the best packing found so far
+        if (!placement.x.empty())
+        {
+            std::cout << "Exact search aborted at height " << placement.height << std::endl;
+            fallback = std::move(placement);
+        }
+    }
 
-            solver_.addConstraint("below_" + std::to_string(i) + "_" + std::to_string(j), 
-                {{y_vars[i], 1.0}, {y_vars[j], -1.0}, {r_vars[i], w_i - h_i}, {p_vars[i][j], -M}, {q_vars[i][j], M}}, '<', M - h_i);
+    auto buildStart = std::chrono::steady_clock::now();
 
-            solver_.addConstraint("right_" + std::to_string(i) + "_" + std::to_string(j), 
-                {{x_vars[i], 1.0}, {x_vars[j], -1.0}, {r_vars[j], -(h_j - w_j)}, {p_vars[i][j], -M}, {q_vars[i][j], M}}, '>', w_j - M);
+    std::vector<ModuleVars> vars = buildModel(clusterModules, targetWidth, targetHeight, lowerBound);
 
-            solver_.addConstraint("above_" + std::to_string(i) + "_" + std::to_string(j), 
-                {{y_vars[i], 1.0}, {y_vars[j], -1.0}, {r_vars[j], -(w_j - h_j)}, {p_vars[i][j], -M}, {q_vars[i][j], -M}}, '>', h_j - 2 * M);
+    if (vars.empty())
+    {
+        solver().reset();
+        if (!fallback.x.empty())
+        {
+            applyFallback();
+            return true;
         }
+        return false;
     }
 
+    // a legal heuristic floorplan of the whole instance hints the binaries,
+    // the packing of an aborted exact search hints them and is the MIP start
+    if (!fallback.x.empty())
+    {
+        applyFallback();
+        guideModel(clusterModules, vars, true);
+        for (int i = 0; i < n; i++)
+        {
+            solver().setStart(vars[i].x, fallback.x[i]);
+            solver().setStart(vars[i].y, fallback.y[i]);
+            solver().setStart(vars[i].r, fallback.rotated[i] ? 1.0 : 0.0);
+        }
+        solver().setStart("Y", fallback.height);
+    }
+    else
+    {
+        guideModel(clusterModules, vars, whole && isLegal());
+    }
+
+    // reset modules because weird shit happening
+    for (auto m : clusterModules)
+    {
+        m->setRotate(false);
+        m->setPosition(Point(0, 0));
+    }
+
+    // legalize node relaxations into incumbents while Gurobi searches
+    if (repairInterval > 0)
+    {
+        solver().setNodeHeuristic([this, clusterModules, vars, targetWidth, targetHeight](const std::function<double(const std::string &)> &relaxed, double best) {
+            return repairNode(clusterModules, vars, targetWidth, targetHeight, relaxed, best);
+        }, repairInterval);
+    }
+
+    double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    solver().reportModel(buildTime);
+    
+    // set objective to minimize 'M' height
+    solver().setObjective({{"Y", 1.0}}, 'M');
+
     // optional height constraint Y <= H
-    //solver_.addConstraint("height_limit", {{"Y", 1.0}}, '<', targetHeight);
+    //solver().addConstraint("height_limit", {{"Y", 1.0}}, '<', targetHeight);
     
     // after all constraints and the objective are set solve the model
     // add a time limit if it takes too long
 
-    solver_.setTimeLimit(3600);
-    solver_.optimize();
+    solver().setTimeLimit(deadline.limit(3600));
+
+    // heights are integers, so half a unit is enough slack on both ends
+    // stop as soon as an incumbent meets the lower bound and skip anything
+    // that is not strictly better than the heuristic we already have,
+    // the exact packing is below that and is kept itself, so it only cuts what is worse
+    solver().setBestObjStop(lowerBound > 0 ? lowerBound + 0.5 : -GRB_INFINITY);
+    if (!fallback.x.empty())
+    {
+        solver().setCutoff(fallback.height + 0.5);
+    }
+    else
+    {
+        solver().setCutoff(upperBound > 0 ? upperBound - 0.5 : GRB_INFINITY);
+    }
+
+    auto solveStart = std::chrono::steady_clock::now();
+    solver().optimize();
+    double solveTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - solveStart).count();
+
+    std::cout << "ILP (" << encodingName(encoding) << ") build " << buildTime << " ms, solve " << solveTime << " ms" << std::endl;
+
+    const int status = solver().getStatus();
+
+    if ((status == GRB_OPTIMAL || status == GRB_USER_OBJ_LIMIT) && whole)
+    {
+        provenOptimal = true;
+    }
+
+    // nothing better from the ILP, the exact packing stands if there is one
+    auto giveUp = [&]() {
+        solver().reset();
+        if (!fallback.x.empty())
+        {
+            applyFallback();
+            return true;
+        }
+        restore();
+        return false;
+    };
 
-    const int status = solver_.getStatus();
+    if (status == GRB_CUTOFF)
+    {
+        std::cout << "Nothing lower than the heuristic floorplan exists, it is optimal" << std::endl;
+        provenOptimal = provenOptimal || whole;
+        return giveUp();
+    }
 
     if (status == GRB_INFEASIBLE)
     {
         std::cout << "ILP unsat!" << std::endl;
-        solver_.reset();
-        return false;
+        return giveUp();
     }
 
     if (status == GRB_TIME_LIMIT || status == GRB_INTERRUPTED) 
     {
-        if (solver_.getSolutionCount() == 0) 
+        if (solver().getSolutionCount() == 0) 
         {
             std::cout << "Time limit reached with NO feasible solution.\n";
-            solver_.reset();
-            return false;
+            return giveUp();
         }
     }
 
     // extract solution from solver
+    ScopedPhase extract("extract");
 
-    double Y = solver_.getVariableValue("Y");
+    double Y = solver().getVariableValue("Y");
 
     for (int i = 0; i < n; i++) 
     {
-        double x = solver_.getVariableValue(x_vars[i]);
-        double y = solver_.getVariableValue(y_vars[i]);
-        double r = solver_.getVariableValue(r_vars[i]);
+        double x = solver().getVariableValue(vars[i].x);
+        double y = solver().getVariableValue(vars[i].y);
+        double r = solver().getVariableValue(vars[i].r);
 
         // convert positions to integers because python drawer freaks out
         int x_int = static_cast<int>(std::round(x));
@@ -165,7 +555,12 @@ bool Floorplanner::solveCluster(Cluster * c, float targetWidth, float targetHeig
         clusterModules[i]->setRotate(b);
     }
 
-    solver_.reset();    // DO NOT delete or comment out this line
+    if (status == GRB_OPTIMAL || status == GRB_USER_OBJ_LIMIT)
+    {
+        remember(static_cast<int>(std::round(Y)));
+    }
+
+    solver().reset();    // DO NOT delete or comment out this line
     return true;
 }
 
@@ -175,10 +570,30 @@ float Floorplanner::category0Opt()
     // Do NOT remove or reorder the following three lines unless you understand the workflow.
     // It shows how to wrap all modules into a top-level Cluster, and solve it.
 
+    // bracket the ILP between the combinatorial lower bound and a skyline packing
+    // when the packing already meets the bound there is nothing left to prove
+    int bound = getLowerBound();
+    int upper = 0;
+
+    skylineOpt();
+    Compactor(getModules()).compact(deadline);
+    if (isLegal())
+    {
+        upper = getHeight();
+        saveIncumbent();
+    }
+
+    if (upper > 0 && upper <= bound)
+    {
+        std::cout << "Skyline packing meets the lower bound " << bound << ", skipping the ILP" << std::endl;
+        provenOptimal = true;
+        return upper;
+    }
+
     clusters.clear();
     clusters.push_back(std::make_unique<Cluster>(modules));
 
-    float finalHeight = solveCluster(clusters[0].get(), spec.targetWidth, spec.targetHeight);
+    float finalHeight = solveCluster(clusters[0].get(), spec.targetWidth, spec.targetHeight, bound, upper);
 
     // you may try to uncomment the following 4 functions to verify if your cluster level 
     // rotate() works
@@ -0,0 +1,218 @@
+#include "formulation.h"
+
+// side binaries of the indicator encoding, indexed by Relation
+static const char * sideFlags[4] = {"sl_", "sb_", "sr_", "sa_"};
+
+Relation relation(const Obstacle &a, const Obstacle &b)
+{
+    if (a.x + a.w <= b.x)
+    {
+        return Relation::Left;
+    }
+    if (a.y + a.h <= b.y)
+    {
+        return Relation::Below;
+    }
+    if (b.x + b.w <= a.x)
+    {
+        return Relation::Right;
+    }
+    return Relation::Above;
+}
+
+ModuleVars Formulation::addModule(const std::string &tag, double w, double h, double xMax, double yMin, double yMax, bool canRotate)
+{
+    ModuleVars m;
+    m.x = "x_" + tag;
+    m.y = "y_" + tag;
+    m.r = "r_" + tag;
+    m.w = w;
+    m.h = h;
+
+    variable(m.x, 0.0, xMax, GRB_CONTINUOUS);
+    variable(m.y, yMin, yMax, GRB_CONTINUOUS);
+    variable(m.r, 0.0, canRotate ? 1.0 : 0.0, GRB_BINARY);
+
+    return m;
+}
+
+void Formulation::addOutline(const ModuleVars &m, const std::string &tag, double width, const std::string &heightVar)
+{
+    // x_i >= 0 and y_i >= 0 are already handled by variable domain
+
+    row("inside_outline_x" + tag, {{m.x, 1.0}, {m.r, m.h - m.w}}, '<', width - m.w);
+    row("inside_outline_y" + tag, {{m.y, 1.0}, {m.r, m.w - m.h}, {heightVar, -1.0}}, '<', -m.h);
+}
+
+void Formulation::addNonOverlap(const ModuleVars &a, const ModuleVars &b, const std::string &tag)
+{
+    if (encoding_ == Encoding::Indicator)
+    {
+        addSides({
+            {{{a.x, 1.0}, {b.x, -1.0}, {a.r, a.h - a.w}}, '<', -a.w},
+            {{{a.y, 1.0}, {b.y, -1.0}, {a.r, a.w - a.h}}, '<', -a.h},
+            {{{a.x, 1.0}, {b.x, -1.0}, {b.r, -(b.h - b.w)}}, '>', b.w},
+            {{{a.y, 1.0}, {b.y, -1.0}, {b.r, -(b.w - b.h)}}, '>', b.h}}, tag);
+        return;
+    }
+
+    std::string p = "p_" + tag;   // non-overlapping flag x
+    std::string q = "q_" + tag;   // non-overlapping flag y
+
+    variable(p, 0.0, 1.0, GRB_BINARY);
+    variable(q, 0.0, 1.0, GRB_BINARY);
+
+    // (p, q) = (0, 0) a left of b, (0, 1) a below b, (1, 0) a right of b, (1, 1) a above b
+
+    row("left_" + tag,
+        {{a.x, 1.0}, {b.x, -1.0}, {a.r, a.h - a.w}, {p, -M}, {q, -M}}, '<', -a.w);
+
+    row("below_" + tag,
+        {{a.y, 1.0}, {b.y, -1.0}, {a.r, a.w - a.h}, {p, -M}, {q, M}}, '<', M - a.h);
+
+    row("right_" + tag,
+        {{a.x, 1.0}, {b.x, -1.0}, {b.r, -(b.h - b.w)}, {p, -M}, {q, M}}, '>', b.w - M);
+
+    row("above_" + tag,
+        {{a.y, 1.0}, {b.y, -1.0}, {b.r, -(b.w - b.h)}, {p, -M}, {q, -M}}, '>', b.h - 2 * M);
+}
+
+void Formulation::addObstacle(const ModuleVars &a, const Obstacle &o, const std::string &tag)
+{
+    if (encoding_ == Encoding::Indicator)
+    {
+        addSides({
+            {{{a.x, 1.0}, {a.r, a.h - a.w}}, '<', o.x - a.w},
+            {{{a.y, 1.0}, {a.r, a.w - a.h}}, '<', o.y - a.h},
+            {{{a.x, 1.0}}, '>', o.x + o.w},
+            {{{a.y, 1.0}}, '>', o.y + o.h}}, tag);
+        return;
+    }
+
+    std::string p = "p_" + tag;
+    std::string q = "q_" + tag;
+
+    variable(p, 0.0, 1.0, GRB_BINARY);
+    variable(q, 0.0, 1.0, GRB_BINARY);
+
+    // same (p, q) meaning as addNonOverlap with the obstacle in place of b
+
+    row("left_" + tag,
+        {{a.x, 1.0}, {a.r, a.h - a.w}, {p, -M}, {q, -M}}, '<', o.x - a.w);
+
+    row("below_" + tag,
+        {{a.y, 1.0}, {a.r, a.w - a.h}, {p, -M}, {q, M}}, '<', o.y + M - a.h);
+
+    row("right_" + tag,
+        {{a.x, 1.0}, {p, -M}, {q, M}}, '>', o.x + o.w - M);
+
+    row("above_" + tag,
+        {{a.y, 1.0}, {p, -M}, {q, -M}}, '>', o.y + o.h - 2 * M);
+}
+
+void Formulation::addObstacles(const ModuleVars &a, const std::vector<Obstacle> &obstacles, const std::string &tag)
+{
+    for (size_t k = 0; k < obstacles.size(); k++)
+    {
+        addObstacle(a, obstacles[k], tag + "_o" + std::to_string(k));
+    }
+}
+
+void Formulation::variable(const std::string &name, double lb, double ub, char type)
+{
+    if (update_)
+    {
+        solver_.setLowerBound(name, lb);
+        solver_.setUpperBound(name, ub);
+        return;
+    }
+    solver_.addVariable(name, lb, ub, type);
+}
+
+// a restated row has the same variables, so every coefficient of it is set again
+void Formulation::row(const std::string &name, const std::vector<std::pair<std::string, double>> &vars, char sense, double rhs)
+{
+    if (update_)
+    {
+        for (const auto& [v, coef] : vars)
+        {
+            solver_.setCoefficient(name, v, coef);
+        }
+        solver_.setRHS(name, rhs);
+        return;
+    }
+    solver_.addConstraint(name, vars, sense, rhs);
+}
+
+void Formulation::addSides(const SideRow (&sides)[4], const std::string &tag)
+{
+    if (update_)
+    {
+        throw std::runtime_error("Indicator rows cannot be changed in place: " + tag);
+    }
+
+    static const char * names[4] = {"left_", "below_", "right_", "above_"};
+
+    std::vector<std::pair<std::string, double>> pick;
+    for (int k = 0; k < 4; k++)
+    {
+        std::string s = sideFlags[k] + tag;
+        variable(s, 0.0, 1.0, GRB_BINARY);
+        solver_.addIndicator(names[k] + tag, s, 1, sides[k].vars, sides[k].sense, sides[k].rhs);
+        pick.push_back({s, 1.0});
+    }
+
+    // exactly one side holds, a module pair never needs two of them
+    row("side_" + tag, pick, '=', 1.0);
+}
+
+void Formulation::prioritize(const ModuleVars &a, int priority)
+{
+    solver_.setBranchPriority(a.r, priority);
+}
+
+void Formulation::prioritizePair(const std::string &tag, int priority)
+{
+    if (encoding_ == Encoding::Indicator)
+    {
+        for (const char * s : sideFlags)
+        {
+            solver_.setBranchPriority(s + tag, priority);
+        }
+        return;
+    }
+
+    solver_.setBranchPriority("p_" + tag, priority);
+    solver_.setBranchPriority("q_" + tag, priority);
+}
+
+void Formulation::hintRotation(const ModuleVars &a, bool rotated, int priority)
+{
+    solver_.setHint(a.r, rotated ? 1.0 : 0.0, priority);
+}
+
+void Formulation::hintPair(const std::string &tag, Relation rel, int priority)
+{
+    for (auto &[name, value] : pairValues(tag, rel))
+    {
+        solver_.setHint(name, value, priority);
+    }
+}
+
+std::vector<std::pair<std::string, double>> Formulation::pairValues(const std::string &tag, Relation rel) const
+{
+    int k = static_cast<int>(rel);
+
+    if (encoding_ == Encoding::Indicator)
+    {
+        std::vector<std::pair<std::string, double>> values;
+        for (int s = 0; s < 4; s++)
+        {
+            values.push_back({sideFlags[s] + tag, s == k ? 1.0 : 0.0});
+        }
+        return values;
+    }
+
+    // (p, q) = (0, 0) left, (0, 1) below, (1, 0) right, (1, 1) above
+    return {{"p_" + tag, k >= 2 ? 1.0 : 0.0}, {"q_" + tag, k % 2 ? 1.0 : 0.0}};
+}
@@ -0,0 +1,132 @@
+#include "geometry.h"
+
+// one pass of the slab sweep, gaps are only closed along x
+static std::vector<Obstacle> mergeSlabs(const std::vector<Obstacle> &rects, double minGap, double width)
+{
+    std::vector<Obstacle> out;
+    if (rects.empty())
+    {
+        return out;
+    }
+
+    // slab boundaries
+    std::vector<double> ys;
+    ys.reserve(2 * rects.size());
+    for (auto &r : rects)
+    {
+        ys.push_back(r.y);
+        ys.push_back(r.y + r.h);
+    }
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+    // rectangles sorted by bottom, swept into an active list
+    std::vector<int> order(rects.size());
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return rects[a].y < rects[b].y; });
+
+    std::vector<int> active;
+    size_t next = 0;
+
+    // open rectangles from the slabs below, keyed by their x interval
+    std::map<std::pair<double, double>, double> open;   // (x1, x2) -> bottom
+
+    auto close = [&](const std::pair<double, double> &span, double bottom, double top) {
+        out.push_back({span.first, bottom, span.second - span.first, top - bottom});
+    };
+
+    for (size_t s = 0; s + 1 < ys.size(); s++)
+    {
+        double y0 = ys[s];
+
+        while (next < order.size() && rects[order[next]].y <= y0)
+        {
+            active.push_back(order[next++]);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(), [&](int i) { return rects[i].y + rects[i].h <= y0; }), active.end());
+
+        // covered x intervals of this slab
+        std::vector<std::pair<double, double>> spans;
+        for (int i : active)
+        {
+            spans.push_back({rects[i].x, rects[i].x + rects[i].w});
+        }
+        std::sort(spans.begin(), spans.end());
+
+        std::vector<std::pair<double, double>> merged;
+        for (auto &sp : spans)
+        {
+            // touching, overlapping or separated by a gap nothing fits into
+            if (!merged.empty() && sp.first - merged.back().second < minGap)
+            {
+                merged.back().second = std::max(merged.back().second, sp.second);
+            }
+            else
+            {
+                merged.push_back(sp);
+            }
+        }
+        if (!merged.empty())
+        {
+            if (merged.front().first < minGap)
+            {
+                merged.front().first = 0.0;
+            }
+            if (width - merged.back().second < minGap)
+            {
+                merged.back().second = std::max(merged.back().second, width);
+            }
+        }
+
+        // extend rectangles that continue, close the ones that do not
+        std::map<std::pair<double, double>, double> still;
+        for (auto &sp : merged)
+        {
+            auto it = open.find(sp);
+            still[sp] = it != open.end() ? it->second : y0;
+        }
+        for (auto &[span, bottom] : open)
+        {
+            if (!still.count(span))
+            {
+                close(span, bottom, y0);
+            }
+        }
+        open.swap(still);
+    }
+
+    for (auto &[span, bottom] : open)
+    {
+        close(span, bottom, ys.back());
+    }
+
+    return out;
+}
+
+std::vector<Obstacle> mergeObstacles(const std::vector<Obstacle> &rects, double minGap, double width)
+{
+    // close the narrow gaps along x, then run again on the transposed result
+    // to close the ones along y (there is no outline edge to snap to on top)
+    std::vector<Obstacle> flat = mergeSlabs(rects, minGap, width);
+
+    std::vector<Obstacle> flipped;
+    flipped.reserve(flat.size());
+    for (auto &r : flat)
+    {
+        flipped.push_back({r.y, r.x, r.h, r.w});
+    }
+    flipped = mergeSlabs(flipped, minGap, std::numeric_limits<double>::infinity());
+
+    std::vector<Obstacle> out;
+    out.reserve(flipped.size());
+    for (auto &r : flipped)
+    {
+        out.push_back({r.y, r.x, r.h, r.w});
+    }
+
+    // the transposed pass cuts along the other axis, keep whichever came out smaller
+    return out.size() < flat.size() ? out : flat;
+}
@@ -0,0 +1,182 @@
+#include "grid.h"
+
+namespace
+{
+    // bits of word wi that fall inside [from, to)
+    uint64_t span(int from, int to, int wi)
+    {
+        int lo = std::max(from - wi * 64, 0);
+        int hi = std::min(to - wi * 64, 64);
+        uint64_t upper = hi == 64 ? ~0ULL : (1ULL << hi) - 1;
+        return upper & (~0ULL << lo);
+    }
+
+    // first index in [from, end) whose bit equals set, end if there is none
+    int nextBit(const uint64_t * bits, int from, int end, bool set)
+    {
+        while (from < end)
+        {
+            int wi = from >> 6;
+            uint64_t word = (set ? bits[wi] : ~bits[wi]) & (~0ULL << (from & 63));
+            if (word)
+            {
+                return std::min(end, wi * 64 + __builtin_ctzll(word));
+            }
+            from = (wi + 1) * 64;
+        }
+        return end;
+    }
+}
+
+OccupancyGrid::OccupancyGrid(int width, int height) : width_(std::max(width, 0)), words_((std::max(width, 0) + 63) / 64)
+{
+    grow(height);
+}
+
+void OccupancyGrid::grow(int rows)
+{
+    if (rows > rows_)
+    {
+        bits_.resize(size_t(rows) * words_, 0);
+        run_.resize(rows, width_);
+        rows_ = rows;
+    }
+}
+
+bool OccupancyGrid::fits(int x, int y, int w, int h) const
+{
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > width_)
+    {
+        return false;
+    }
+
+    for (int r = y; r < std::min(y + h, rows_); r++)
+    {
+        if (nextBit(row(r), x, x + w, true) < x + w)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OccupancyGrid::claim(int x, int y, int w, int h)
+{
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > width_)
+    {
+        return false;
+    }
+
+    grow(y + h);
+
+    bool free = true;
+    for (int r = y; r < y + h; r++)
+    {
+        uint64_t * bits = row(r);
+        for (int wi = x >> 6; wi <= (x + w - 1) >> 6; wi++)
+        {
+            uint64_t mask = span(x, x + w, wi);
+            free = free && !(bits[wi] & mask);
+            bits[wi] |= mask;
+        }
+    }
+    return free;
+}
+
+bool OccupancyGrid::place(int x, int y, int w, int h)
+{
+    if (!claim(x, y, w, h))
+    {
+        return false;
+    }
+
+    levels_.insert(y + h);
+    for (int r = y; r < y + h; r++)
+    {
+        const uint64_t * bits = row(r);
+        run_[r] = 0;
+        for (int a = nextBit(bits, 0, width_, false); a < width_; )
+        {
+            int b = nextBit(bits, a, width_, true);
+            run_[r] = std::max(run_[r], b - a);
+            a = nextBit(bits, b, width_, false);
+        }
+
+        // a full row never takes anything again
+        if (run_[r] == 0)
+        {
+            levels_.erase(r);
+        }
+    }
+    return true;
+}
+
+bool OccupancyGrid::findLowestLeft(int w, int h, int &x, int &y) const
+{
+    if (w <= 0 || h <= 0 || w > width_)
+    {
+        return false;
+    }
+
+    for (int level : levels_)
+    {
+        // nothing was ever placed up here
+        if (level >= rows_)
+        {
+            x = 0;
+            y = level;
+            return true;
+        }
+
+        // every row the rectangle would cover needs a free run of w somewhere
+        int top = std::min(level + h, rows_);
+        bool possible = true;
+        for (int r = level; r < top && possible; r++)
+        {
+            possible = run_[r] >= w;
+        }
+        if (!possible)
+        {
+            continue;
+        }
+
+        // free runs of the bottom row at least w long, a candidate x in one of them
+        // jumps past the first taken cell any higher row has inside [x, x + w)
+        const uint64_t * base = row(level);
+        int pos = 0;
+        while (pos < width_)
+        {
+            int a = nextBit(base, pos, width_, false);
+            if (a + w > width_)
+            {
+                break;
+            }
+            int b = nextBit(base, a, width_, true);
+
+            int c = a;
+            while (c + w <= b)
+            {
+                bool blocked = false;
+                for (int r = level + 1; r < top; r++)
+                {
+                    int taken = nextBit(row(r), c, c + w, true);
+                    if (taken < c + w)
+                    {
+                        c = nextBit(row(r), taken, b, false);
+                        blocked = true;
+                        break;
+                    }
+                }
+
+                if (!blocked)
+                {
+                    x = c;
+                    y = level;
+                    return true;
+                }
+            }
+            pos = b;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,171 @@
+#include "floorplanner.h"
+
+std::vector<Module *> Floorplanner::getModules()
+{
+    std::vector<Module *> out;
+    out.reserve(modules.size());
+
+    for (auto &m : modules)
+    {
+        out.push_back(m.get());
+    }
+    return out;
+}
+
+// fresh copy of another floorplanner's modules and settings, used to give
+// every portfolio worker a placement of its own to work on
+void Floorplanner::copyFrom(const Floorplanner &other)
+{
+    modules.clear();
+    modules.reserve(other.modules.size());
+    for (auto &m : other.modules)
+    {
+        modules.push_back(std::unique_ptr<Module>(new Module(m->getId(), m->getOrgWidth(), m->getOrgHeight())));
+    }
+
+    spec = other.spec;
+    tempering = other.tempering;
+    compaction = other.compaction;
+    windowSize = other.windowSize;
+    windowTime = other.windowTime;
+    groupSize = other.groupSize;
+    encoding = other.encoding;
+    repairInterval = other.repairInterval;
+    exactSize = other.exactSize;
+    heightBound = other.heightBound;
+    setLogging(other.logFile, other.logConsole);
+    if (other.telemetry)
+    {
+        setTelemetry(other.telemetry);
+    }
+    deadline = other.deadline.fork();
+}
+
+int Floorplanner::getHeight()
+{
+    int height = 0;
+    for (auto &m : modules)
+    {
+        height = std::max(height, int(m->getPosition().y()) + m->getRotatedHeight());
+    }
+    return height;
+}
+
+int Floorplanner::getLowerBound()
+{
+    if (heightBound < 0)
+    {
+        LowerBound lb(getModules(), spec.targetWidth);
+        std::cout << "Lower bounds: area " << lb.area << ", tallest " << lb.tallest << ", mmv " << lb.mmv << std::endl;
+        heightBound = lb.get();
+    }
+    return heightBound;
+}
+
+// same ordering as the shelf packer but modules drop into the lowest gap
+// of the skyline instead of always opening a new shelf
+float Floorplanner::skylineOpt()
+{
+    SkylinePacker packer(getModules(), spec.targetWidth);
+    Sequence seq = tallestFirst(packer);
+
+    std::vector<int> xs, ys;
+    int height = packer.pack(seq, xs, ys);
+    packer.apply(seq, xs, ys);
+
+    return height;
+}
+
+// bottom-left fill on an occupancy bitmap, unlike the skyline a module may also
+// drop into a hole under an overhang, biggest modules first, each in whichever
+// orientation ends lower
+float Floorplanner::blfOpt()
+{
+    std::vector<Module *> list = getModules();
+    std::stable_sort(list.begin(), list.end(), [](Module * a, Module * b) {
+        return a->getOrgWidth() * a->getOrgHeight() > b->getOrgWidth() * b->getOrgHeight();
+    });
+
+    OccupancyGrid grid(spec.targetWidth);
+    int height = 0;
+    for (auto m : list)
+    {
+        int bestX = 0, bestY = height;
+        bool bestRotated = false;
+        int bestTop = std::numeric_limits<int>::max();
+
+        for (int r = 0; r < 2; r++)
+        {
+            int w = r ? m->getOrgHeight() : m->getOrgWidth();
+            int h = r ? m->getOrgWidth() : m->getOrgHeight();
+            int x, y;
+            if (grid.findLowestLeft(w, h, x, y) && (y + h < bestTop || (y + h == bestTop && y < bestY)))
+            {
+                bestX = x;
+                bestY = y;
+                bestRotated = r;
+                bestTop = y + h;
+            }
+        }
+
+        m->setRotate(bestRotated);
+        m->setPosition(Point(bestX, bestY));
+        grid.place(bestX, bestY, m->getRotatedWidth(), m->getRotatedHeight());
+        height = std::max(height, bestY + m->getRotatedHeight());
+    }
+
+    return height;
+}
+
+// single chain simulated annealing, the baseline for parallel tempering
+float Floorplanner::annealOpt()
+{
+    SkylinePacker packer(getModules(), spec.targetWidth);
+    Tempering annealer(packer, tallestFirst(packer));
+
+    TemperingOptions opt = tempering;
+    opt.replicas = 1;
+    opt.cooling = true;
+    opt.timeLimit = deadline.limit(opt.timeLimit);
+
+    annealer.run(opt, deadline);
+    annealer.report();
+
+    std::vector<int> xs, ys;
+    int height = packer.pack(annealer.getBest(), xs, ys);
+    packer.apply(annealer.getBest(), xs, ys);
+
+    return height;
+}
+
+// replica exchange, one replica per thread at a ladder of temperatures
+float Floorplanner::temperingOpt()
+{
+    SkylinePacker packer(getModules(), spec.targetWidth);
+    Tempering annealer(packer, tallestFirst(packer));
+
+    TemperingOptions opt = tempering;
+    opt.cooling = false;
+
+    annealer.run(opt, deadline);
+    annealer.report();
+
+    std::vector<int> xs, ys;
+    int height = packer.pack(annealer.getBest(), xs, ys);
+    packer.apply(annealer.getBest(), xs, ys);
+
+    return height;
+}
+
+// push everything down and left along the constraint graphs
+// never makes a legal placement worse so it is safe after any strategy
+float Floorplanner::compact()
+{
+    int before = getHeight();
+
+    Compactor compactor(getModules());
+    int after = compactor.compact(deadline);
+
+    std::cout << "Compaction: height " << before << " -> " << after << std::endl;
+    return after;
+}
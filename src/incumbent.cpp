@@ -0,0 +1,237 @@
+#include "floorplanner.h"
+
+// quiet version of validityCheck
+// the bitmap check costs about width * height / 64 words, the sweep n log n plus
+// the pairs whose x ranges meet, the bitmap wins once the floorplan is dense in modules
+bool Floorplanner::isLegal()
+{
+    ScopedPhase phase("isLegal");
+    long words = (long(spec.targetWidth) + 63) / 64 * getHeight();
+    return words <= 8L * long(modules.size()) ? isLegalGrid() : isLegalSweep();
+}
+
+bool Floorplanner::insideOutline(const std::vector<Module *> &list)
+{
+    for (auto m : list)
+    {
+        if (m->getPosition().x() < -0.1 || m->getPosition().y() < -0.1 ||
+            m->getPosition().x() + m->getRotatedWidth() > spec.targetWidth + 0.1 ||
+            m->getPosition().y() + m->getRotatedHeight() > spec.targetHeight + 0.1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Floorplanner::isLegalSweep()
+{
+    return isLegalSweep(getModules());
+}
+
+// sweeps along x so only modules whose x ranges meet are compared
+bool Floorplanner::isLegalSweep(const std::vector<Module *> &list)
+{
+    if (!insideOutline(list))
+    {
+        return false;
+    }
+
+    int n = list.size();
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return list[a]->getPosition().x() < list[b]->getPosition().x();
+    });
+
+    for (int a = 0; a < n; a++)
+    {
+        Module * m1 = list[order[a]];
+        float right = m1->getPosition().x() + m1->getRotatedWidth();
+
+        for (int b = a + 1; b < n; b++)
+        {
+            Module * m2 = list[order[b]];
+            if (m2->getPosition().x() >= right)
+            {
+                break;
+            }
+
+            if (!(m1->getPosition().y() + m1->getRotatedHeight() <= m2->getPosition().y() ||
+                  m2->getPosition().y() + m2->getRotatedHeight() <= m1->getPosition().y()))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// paints every module into an occupancy bitmap, an overlap finds its cells taken
+bool Floorplanner::isLegalGrid()
+{
+    if (!insideOutline(getModules()))
+    {
+        return false;
+    }
+
+    OccupancyGrid grid(spec.targetWidth, getHeight());
+    for (auto &m : modules)
+    {
+        if (!grid.claim(int(m->getPosition().x()), int(m->getPosition().y()), m->getRotatedWidth(), m->getRotatedHeight()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// keep the current placement if it is legal and lower than the incumbent
+bool Floorplanner::saveIncumbent()
+{
+    if (modules.empty() || !isLegal())
+    {
+        return false;
+    }
+
+    int height = getHeight();
+
+    {
+        std::lock_guard<std::mutex> lock(incumbentMutex);
+        if (incumbent.height >= 0 && incumbent.height <= height)
+        {
+            return false;
+        }
+
+        int n = modules.size();
+        incumbent.x.resize(n);
+        incumbent.y.resize(n);
+        incumbent.rotated.resize(n);
+
+        for (int i = 0; i < n; i++)
+        {
+            incumbent.x[i] = std::lround(modules[i]->getPosition().x());
+            incumbent.y[i] = std::lround(modules[i]->getPosition().y());
+            incumbent.rotated[i] = modules[i]->isRotated();
+        }
+        incumbent.height = height;
+    }
+
+    if (onIncumbent)
+    {
+        onIncumbent(*this);
+    }
+    return true;
+}
+
+// put the incumbent back if the current placement is illegal or worse
+void Floorplanner::restoreIncumbent()
+{
+    std::lock_guard<std::mutex> lock(incumbentMutex);
+    if (incumbent.height < 0)
+    {
+        return;
+    }
+
+    if (isLegal() && getHeight() <= incumbent.height)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        modules[i]->setRotate(incumbent.rotated[i]);
+        modules[i]->setPosition(Point(incumbent.x[i], incumbent.y[i]));
+    }
+}
+
+// only touches the incumbent so it is safe to call from another thread
+// while a strategy is still moving modules around
+bool Floorplanner::writeIncumbent(std::string outputFile)
+{
+    std::lock_guard<std::mutex> lock(incumbentMutex);
+    if (incumbent.height < 0)
+    {
+        std::cout << "No legal floorplan found yet, nothing to write" << std::endl;
+        return false;
+    }
+
+    std::cout << "Writing best floorplan so far (height " << incumbent.height << "): " << outputFile << std::endl;
+    std::ofstream outfile(outputFile);
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        outfile << modules[i]->getId() << "\t" << incumbent.x[i] << "\t" << incumbent.y[i] << "\t" << (incumbent.rotated[i] ? 1 : 0) << std::endl;
+    }
+    return true;
+}
+
+// everything besides the instance that changes what solve() produces
+std::string Floorplanner::parameters() const
+{
+    std::ostringstream p;
+    p << "strategy=" << strategy << ";encoding=" << encodingName(encoding) << ";compaction=" << compaction
+      << ";window=" << windowSize << "," << windowTime << ";group=" << groupSize << ";repair=" << repairInterval << ";exact=" << exactSize
+      << ";tempering=" << tempering.replicas << "," << tempering.timeLimit << "," << tempering.swapInterval << ","
+      << tempering.tMax << "," << tempering.tMin << "," << tempering.seed << ";goodEnough=" << goodEnough << ";portfolio=";
+    for (auto &s : portfolio)
+    {
+        p << s << ",";
+    }
+    return p.str();
+}
+
+// take a cached placement, true if it is legal for the current instance
+bool Floorplanner::restoreFrom(const CacheEntry &entry)
+{
+    if (entry.x.size() != modules.size())
+    {
+        return false;
+    }
+
+    // a rejected entry leaves the placement as it was
+    std::vector<std::pair<Point, bool>> saved;
+    for (auto &m : modules)
+    {
+        saved.push_back({m->getPosition(), m->isRotated()});
+    }
+
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        modules[i]->setRotate(entry.rotated[i]);
+        modules[i]->setPosition(Point(entry.x[i], entry.y[i]));
+    }
+
+    if (!isLegal() || getHeight() != entry.height)
+    {
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            modules[i]->setRotate(saved[i].second);
+            modules[i]->setPosition(saved[i].first);
+        }
+        return false;
+    }
+
+    provenOptimal = entry.optimal;
+    saveIncumbent();
+    return true;
+}
+
+CacheEntry Floorplanner::toCacheEntry()
+{
+    CacheEntry entry;
+    for (auto &m : modules)
+    {
+        entry.x.push_back(int(m->getPosition().x()));
+        entry.y.push_back(int(m->getPosition().y()));
+        entry.rotated.push_back(m->isRotated());
+    }
+    entry.height = getHeight();
+    entry.bound = getLowerBound();
+    entry.optimal = provenOptimal;
+    return entry;
+}
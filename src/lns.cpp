@@ -0,0 +1,265 @@
+#include "floorplanner.h"
+
+// re-optimize a window of modules exactly with every other module frozen as an obstacle
+// the window may move anywhere in the band [yLow, yHigh] across the full width
+// its current placement is passed as the MIP start so the band never gets worse
+// tops below topFloor are free, the objective only starts counting above it
+// the model stays in the solver afterwards, the next window of the same size restates it
+// in place if it has obstacle slots enough, the slots it does not need are parked above
+// the band, so Gurobi keeps its model instead of building one per window
+bool Floorplanner::solveWindow(const std::vector<Module *> &window, const std::vector<Obstacle> &fixed, int yLow, int yHigh, double timeLimit, int topFloor)
+{
+    ScopedPhase phase("solveWindow");
+
+    auto buildStart = std::chrono::steady_clock::now();
+    int n = window.size();
+
+    // the fixed modules only matter through the shape of their union,
+    // so they go into the model as a few merged rectangles
+    double minGap = std::numeric_limits<double>::infinity();
+    for (auto m : window)
+    {
+        minGap = std::min<double>(minGap, std::min(m->getOrgWidth(), m->getOrgHeight()));
+    }
+    std::vector<Obstacle> obstacles = mergeObstacles(fixed, minGap, spec.targetWidth);
+    std::cout << "Window of " << n << " modules against " << obstacles.size() << " obstacles (" << fixed.size() << " fixed modules)" << std::endl;
+
+    // obstacles reach into the band but may end above it, the big-M has to cover their tops
+    double M = std::max<double>(spec.targetWidth, yHigh);
+    for (auto &o : obstacles)
+    {
+        M = std::max(M, o.y + o.h);
+    }
+
+    bool reuse = encoding == Encoding::BigM && windowModules == n && windowObstacles >= int(obstacles.size());
+    if (reuse)
+    {
+        countEvent("solveWindow.reuse");
+    }
+    else
+    {
+        releaseWindow();
+    }
+
+    std::vector<Obstacle> slots = obstacles;
+    slots.resize(std::max<size_t>(slots.size(), reuse ? windowObstacles : 0), Obstacle{0.0, double(yHigh), 0.0, 0.0});
+
+    Formulation formulation(solver(), M, encoding, reuse);
+
+    std::vector<ModuleVars> vars(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        Module * m = window[i];
+        bool canRotate = m->getOrgHeight() <= spec.targetWidth;
+        vars[i] = formulation.addModule(std::to_string(i), m->getOrgWidth(), m->getOrgHeight(), spec.targetWidth, yLow, yHigh, canRotate);
+    }
+
+    // top of the window band
+    int yFloor = std::min(std::max(yLow, topFloor), yHigh);
+    if (reuse)
+    {
+        solver().setLowerBound("Y", yFloor);
+        solver().setUpperBound("Y", yHigh);
+    }
+    else
+    {
+        solver().addVariable("Y", yFloor, yHigh, GRB_CONTINUOUS);
+    }
+
+    // lowest band first, then sink the modules inside it
+    // the sink term sums to less than one so it never trades against the band height
+    double eps = 1.0 / (double(n) * (yHigh + 1));
+    if (reuse)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            solver().setObjectiveCoefficient(vars[i].y, eps);
+        }
+    }
+    else
+    {
+        std::vector<std::pair<std::string, double>> objective = {{"Y", 1.0}};
+        for (int i = 0; i < n; i++)
+        {
+            objective.push_back({vars[i].y, eps});
+        }
+        solver().setObjective(objective, 'M');
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        formulation.addOutline(vars[i], std::to_string(i), spec.targetWidth, "Y");
+
+        for (int j = i + 1; j < n; j++)
+        {
+            formulation.addNonOverlap(vars[i], vars[j], std::to_string(i) + "_" + std::to_string(j));
+        }
+
+        formulation.addObstacles(vars[i], slots, std::to_string(i));
+
+        // a spare slot is an empty rectangle on top of the band, the module stays below it
+        for (size_t k = obstacles.size(); k < slots.size(); k++)
+        {
+            for (auto &[name, value] : formulation.pairValues(std::to_string(i) + "_o" + std::to_string(k), Relation::Below))
+            {
+                solver().setLowerBound(name, value);
+                solver().setUpperBound(name, value);
+            }
+        }
+    }
+
+    // current placement as the start, and as hints for the pair binaries
+    guideModel(window, vars, true);
+
+    int top = yFloor;
+    for (int i = 0; i < n; i++)
+    {
+        solver().setStart(vars[i].x, window[i]->getPosition().x());
+        solver().setStart(vars[i].y, window[i]->getPosition().y());
+        solver().setStart(vars[i].r, window[i]->isRotated() ? 1.0 : 0.0);
+        top = std::max(top, int(window[i]->getPosition().y()) + window[i]->getRotatedHeight());
+    }
+    solver().setStart("Y", top);
+
+    windowModules = n;
+    windowObstacles = slots.size();
+
+    double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    if (!reuse)
+    {
+        solver().reportModel(buildTime);
+    }
+
+    solver().setTimeLimit(timeLimit);
+    auto solveStart = std::chrono::steady_clock::now();
+    solver().optimize();
+    double solveTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - solveStart).count();
+
+    std::cout << "Window model " << (reuse ? "updated" : "built") << " in " << buildTime << " ms, solved in " << solveTime << " ms" << std::endl;
+
+    if (solver().getSolutionCount() == 0)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int x = static_cast<int>(std::round(solver().getVariableValue(vars[i].x)));
+        int y = static_cast<int>(std::round(solver().getVariableValue(vars[i].y)));
+        bool r = solver().getVariableValue(vars[i].r) > 0.5;
+
+        window[i]->setRotate(r);
+        window[i]->setPosition(Point(x, y));
+    }
+
+    return true;
+}
+
+// large neighbourhood search
+// start from the skyline packing, then repeatedly cut out a horizontal band of
+// windowSize modules, re-solve it exactly against the rest and compact
+// windows are taken from the top down (the top band sets the height) and the
+// band boundaries shift by half a window every cycle so modules meet new neighbours
+float Floorplanner::lnsOpt()
+{
+    skylineOpt();
+
+    std::vector<Module *> list = getModules();
+    Compactor(list).compact(deadline);
+    saveIncumbent();
+
+    int n = list.size();
+    int k = std::min(windowSize, n);
+    int height = getHeight();
+    int cycle = 0;
+    bool improved = true;
+
+    std::cout << "LNS start height " << height << std::endl;
+
+    while (improved && k > 0 && !deadline.expired())
+    {
+        improved = false;
+
+        std::vector<Module *> sorted = list;
+        std::sort(sorted.begin(), sorted.end(), [](Module * a, Module * b) {
+            return a->getPosition().y() + a->getRotatedHeight() > b->getPosition().y() + b->getRotatedHeight();
+        });
+
+        int offset = (cycle % 2) * (k / 2);
+        for (int start = -offset; start < n; start += k)
+        {
+            int first = std::max(0, start);
+            int last = std::min(n, start + k);
+            if (deadline.expired())
+            {
+                break;
+            }
+
+            if (last - first < 2)
+            {
+                continue;
+            }
+
+            std::vector<Module *> window(sorted.begin() + first, sorted.begin() + last);
+            std::unordered_set<Module *> inWindow(window.begin(), window.end());
+
+            int yLow = std::numeric_limits<int>::max();
+            int yHigh = 0;
+            for (auto m : window)
+            {
+                yLow = std::min(yLow, int(m->getPosition().y()));
+                yHigh = std::max(yHigh, int(m->getPosition().y()) + m->getRotatedHeight());
+            }
+
+            // everything else reaching into the band is frozen
+            std::vector<Obstacle> obstacles;
+            for (auto m : list)
+            {
+                double y = m->getPosition().y();
+                if (inWindow.count(m) || y >= yHigh || y + m->getRotatedHeight() <= yLow)
+                {
+                    continue;
+                }
+                obstacles.push_back({m->getPosition().x(), y, double(m->getRotatedWidth()), double(m->getRotatedHeight())});
+            }
+
+            std::vector<std::pair<Point, bool>> saved;
+            for (auto m : list)
+            {
+                saved.push_back({m->getPosition(), m->isRotated()});
+            }
+
+            if (!solveWindow(window, obstacles, yLow, yHigh, deadline.limit(windowTime)))
+            {
+                continue;
+            }
+
+            Compactor(list).compact(deadline);
+            int h = getHeight();
+
+            if (h > height || !isLegal())
+            {
+                // rounding or the merged obstacles went wrong somewhere, go back to the old placement
+                for (int i = 0; i < n; i++)
+                {
+                    list[i]->setRotate(saved[i].second);
+                    list[i]->setPosition(saved[i].first);
+                }
+                continue;
+            }
+
+            if (h < height)
+            {
+                std::cout << "LNS window " << first << "-" << last << ": height " << height << " -> " << h << std::endl;
+                height = h;
+                improved = true;
+                saveIncumbent();
+            }
+        }
+
+        cycle++;
+    }
+
+    return height;
+}
@@ -1,23 +1,327 @@
 #include "gurobi_c++.h"
 #include "floorplanner.h"
+#include "portfolio.h"
 #include <iostream>
+#include <thread>
+#include <condition_variable>
+#include <sstream>
 
 using namespace std;
 
-int main(int argc, char** argv) 
+static void usage(const char * prog)
 {
-    if (argc != 4) 
+    std::cerr << "Usage: " << prog << " <inputFile> <specFile> <outputFile> [options]" << std::endl;
+    std::cerr << "  --strategy <name>     ilp, shelf, skyline, blf, anneal, tempering, lns, bisect, augment, cluster or portfolio" << std::endl;
+    std::cerr << "  --portfolio <list>    comma separated strategies raced by the portfolio" << std::endl;
+    std::cerr << "  --good-enough <h>     portfolio stops once a floorplan this low is found" << std::endl;
+    std::cerr << "  --threads <n>         tempering replicas, one per thread" << std::endl;
+    std::cerr << "  --anneal-time <sec>   wall clock time for anneal and tempering" << std::endl;
+    std::cerr << "  --seed <n>            random seed for anneal and tempering" << std::endl;
+    std::cerr << "  --window <k>          modules per lns window" << std::endl;
+    std::cerr << "  --window-time <sec>   ILP time cap per lns window or augment group" << std::endl;
+    std::cerr << "  --group <k>           modules per augmentation step or per cluster" << std::endl;
+    std::cerr << "  --time-budget <sec>   wall clock budget for the whole flow" << std::endl;
+    std::cerr << "  --formulation <name>  non-overlap encoding of the ILPs, bigm or indicator" << std::endl;
+    std::cerr << "  --repair-interval <n> MIP nodes between relaxation repairs, 0 turns them off" << std::endl;
+    std::cerr << "  --exact-size <n>      clusters up to n modules skip the ILP for an exact search, 0 for never (max 10)" << std::endl;
+    std::cerr << "                        also the largest cluster of the cluster strategy" << std::endl;
+    std::cerr << "  --log-file <path>     Gurobi log file, empty for none (default gurobi.log)" << std::endl;
+    std::cerr << "  --log-console <0|1>   Gurobi log on the console" << std::endl;
+    std::cerr << "  --telemetry <path>    solver progress as NDJSON, - for stderr" << std::endl;
+    std::cerr << "  --profile <path>      phase timings, counters and memory as JSON at exit, - for stderr" << std::endl;
+    std::cerr << "  --trace <path>        Chrome trace_event JSON of the run at exit, for Perfetto" << std::endl;
+    std::cerr << "  --cache <dir>         reuse results of identical runs stored in dir" << std::endl;
+    std::cerr << "  --cache-size <MB>     least recently used cache entries go beyond this (default 64)" << std::endl;
+    std::cerr << "  --eco <path>          start from this earlier output and only re-place what --eco-delta changes" << std::endl;
+    std::cerr << "  --eco-delta <path>    add <id> <w> <h>, remove <id> and resize <id> <w> <h> lines" << std::endl;
+    std::cerr << "  --no-compact          skip the longest path compaction after solving" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
     {
-        std::cerr << "Usage: " << argv[0] << " <inputFile> <specFile> <outputFile>" << std::endl;
+        usage(argv[0]);
         return 1;
     }
 
     Floorplanner fp_;
+    TemperingOptions tempering;
+    int window = 10;
+    double windowTime = 10.0;
+    double budget = 0.0;
+    std::vector<std::string> portfolio = {"shelf", "skyline", "tempering", "ilp", "lns"};
+    int goodEnough = 0;
+    std::string logFile = "gurobi.log";
+    bool logConsole = true;
+    std::ofstream telemetry;
+    std::string profile;
+    std::string trace;
+    std::string cacheDir;
+    double cacheMB = 64.0;
+    std::string ecoBase;
+    std::string ecoDelta;
+    tempering.replicas = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 4; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-compact")
+        {
+            fp_.setCompaction(false);
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (arg == "--strategy")
+        {
+            fp_.setStrategy(argv[++i]);
+        }
+        else if (arg == "--threads")
+        {
+            tempering.replicas = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--anneal-time")
+        {
+            tempering.timeLimit = std::atof(argv[++i]);
+        }
+        else if (arg == "--seed")
+        {
+            tempering.seed = std::atoi(argv[++i]);
+        }
+        else if (arg == "--portfolio")
+        {
+            portfolio.clear();
+            std::stringstream list(argv[++i]);
+            std::string s;
+            while (std::getline(list, s, ','))
+            {
+                portfolio.push_back(s);
+            }
+        }
+        else if (arg == "--good-enough")
+        {
+            goodEnough = std::atoi(argv[++i]);
+        }
+        else if (arg == "--time-budget")
+        {
+            budget = std::atof(argv[++i]);
+        }
+        else if (arg == "--window")
+        {
+            window = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--group")
+        {
+            fp_.setGroup(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--formulation")
+        {
+            Encoding encoding;
+            if (!parseEncoding(argv[++i], encoding))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            fp_.setEncoding(encoding);
+        }
+        else if (arg == "--repair-interval")
+        {
+            fp_.setRepairInterval(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (arg == "--exact-size")
+        {
+            fp_.setExactSize(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (arg == "--log-file")
+        {
+            logFile = argv[++i];
+        }
+        else if (arg == "--log-console")
+        {
+            logConsole = std::atoi(argv[++i]) != 0;
+        }
+        else if (arg == "--telemetry")
+        {
+            std::string path = argv[++i];
+            // stdout carries the solver log and progress prints, the NDJSON stays apart from them
+            if (path == "-")
+            {
+                fp_.setTelemetry(&std::cerr);
+            }
+            else
+            {
+                telemetry.open(path);
+                if (!telemetry)
+                {
+                    std::cerr << "Cannot open " << path << std::endl;
+                    return 1;
+                }
+                fp_.setTelemetry(&telemetry);
+            }
+        }
+        else if (arg == "--profile")
+        {
+            profile = argv[++i];
+            enableProfile();
+        }
+        else if (arg == "--trace")
+        {
+            trace = argv[++i];
+            enableTrace();
+            setTraceThread("main");
+        }
+        else if (arg == "--cache")
+        {
+            cacheDir = argv[++i];
+        }
+        else if (arg == "--cache-size")
+        {
+            cacheMB = std::atof(argv[++i]);
+        }
+        else if (arg == "--eco")
+        {
+            ecoBase = argv[++i];
+        }
+        else if (arg == "--eco-delta")
+        {
+            ecoDelta = argv[++i];
+        }
+        else if (arg == "--window-time")
+        {
+            windowTime = std::atof(argv[++i]);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (ecoBase.empty() != ecoDelta.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    fp_.setTempering(tempering);
+    fp_.setLogging(logFile, logConsole);
+    fp_.setWindow(window, windowTime);
+    fp_.setPortfolio(portfolio, goodEnough);
+
+    auto writeReport = [&]() {
+        if (!trace.empty())
+        {
+            std::ofstream out(trace);
+            writeTrace(out);
+        }
+        if (profile.empty())
+        {
+            return;
+        }
+        if (profile == "-")
+        {
+            writeProfile(std::cerr);
+            return;
+        }
+        std::ofstream out(profile);
+        writeProfile(out);
+    };
+
+    // the stages work against the budget minus a small reserve for writing the output,
+    // the watchdog writes the best floorplan so far if they overrun the full budget anyway
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    bool done = false;
+    std::thread watchdog;
+
+    if (budget > 0.0)
+    {
+        double reserve = std::min(1.0, 0.1 * budget);
+        fp_.setDeadline(Deadline(budget - reserve));
+
+        watchdog = std::thread([&]() {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            if (!doneCv.wait_for(lock, std::chrono::duration<double>(budget), [&]() { return done; }))
+            {
+                std::cout << "Time budget exceeded" << std::endl;
+                bool written = fp_.writeIncumbent(argv[3]);
+                writeReport();
+                std::_Exit(written ? 0 : 1);
+            }
+        });
+    }
+
+    // every way out has to stop the watchdog, a thread still joinable at exit terminates
+    auto stopWatchdog = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+        }
+        if (watchdog.joinable())
+        {
+            doneCv.notify_all();
+            watchdog.join();
+        }
+    };
+
     fp_.initialize(argv[1]);
     fp_.setSpec(Spec(argv[2]));
-    fp_.solve();
+
+    // a shelf packing takes no time and gives the watchdog something to write
+    // should it fire before a strategy saved a floorplan
+    if (budget > 0.0)
+    {
+        fp_.category1Opt();
+        fp_.saveIncumbent();
+    }
+
+    // an ECO run edits the instance and the earlier placement instead of solving
+    if (!ecoBase.empty() && !fp_.applyEco(ecoBase, ecoDelta))
+    {
+        stopWatchdog();
+        return 1;
+    }
+
+    // an identical earlier run, same instance, spec and parameters, skips solving
+    std::unique_ptr<ResultCache> cache;
+    uint64_t key = 0;
+    bool cached = false;
+    if (!cacheDir.empty() && ecoBase.empty())
+    {
+        cache = std::make_unique<ResultCache>(cacheDir, uintmax_t(cacheMB * 1024 * 1024));
+        key = ResultCache::key(fp_.getModules(), fp_.getSpec(), fp_.parameters() + ";budget=" + std::to_string(budget));
+
+        CacheEntry entry;
+        if (cache->load(key, fp_.getModules().size(), entry) && fp_.restoreFrom(entry))
+        {
+            std::cout << "Cache hit: height " << entry.height << ", lower bound " << entry.bound << (entry.optimal ? " (optimal)" : "") << std::endl;
+            cached = true;
+        }
+    }
+
+    if (!cached && ecoBase.empty())
+    {
+        fp_.solve();
+        if (cache && fp_.isLegal())
+        {
+            cache->store(key, fp_.toCacheEntry());
+        }
+    }
     fp_.validityCheck();    // you can comment out this function
-    fp_.writeOutput(argv[3]);
+
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        fp_.writeOutput(argv[3]);
+        done = true;
+    }
+    stopWatchdog();
+
+    writeReport();
 
     return 0;
 }
@@ -0,0 +1,144 @@
+#include "packer.h"
+
+SkylinePacker::SkylinePacker(const std::vector<Module *> &modules, int targetWidth) : modules_(modules), targetWidth_(targetWidth)
+{
+    width_.reserve(modules.size());
+    height_.reserve(modules.size());
+
+    for (auto m : modules)
+    {
+        width_.push_back(m->getOrgWidth());
+        height_.push_back(m->getOrgHeight());
+    }
+}
+
+int SkylinePacker::pack(const Sequence &seq, std::vector<int> &xs, std::vector<int> &ys)
+{
+    xs.assign(width_.size(), 0);
+    ys.assign(width_.size(), 0);
+
+    skyline_.clear();
+    skyline_.push_back({0, targetWidth_, 0});
+
+    int packHeight = 0;
+
+    for (int idx : seq.order)
+    {
+        int w = getWidth(idx, seq.rotated[idx]);
+        int h = getHeight(idx, seq.rotated[idx]);
+
+        // find the lowest then leftmost segment the module can start on
+        int bestX = -1;
+        int bestY = std::numeric_limits<int>::max();
+        size_t bestSeg = 0;
+
+        for (size_t i = 0; i < skyline_.size(); i++)
+        {
+            int x = skyline_[i].x;
+            if (x + w > targetWidth_)
+            {
+                break;
+            }
+
+            // the module rests on the highest segment below its span
+            int y = 0;
+            int covered = 0;
+            for (size_t j = i; j < skyline_.size() && covered < w; j++)
+            {
+                y = std::max(y, skyline_[j].y);
+                covered += skyline_[j].width;
+            }
+
+            if (y < bestY)
+            {
+                bestX = x;
+                bestY = y;
+                bestSeg = i;
+            }
+        }
+
+        // wider than the outline, stack it on top so the height still reflects it
+        if (bestX < 0)
+        {
+            bestX = 0;
+            bestY = packHeight;
+            bestSeg = 0;
+        }
+
+        xs[idx] = bestX;
+        ys[idx] = bestY;
+        packHeight = std::max(packHeight, bestY + h);
+
+        // raise the skyline under the module
+        int right = std::min(bestX + w, targetWidth_);
+        size_t j = bestSeg;
+        while (j < skyline_.size() && skyline_[j].x < right)
+        {
+            int segRight = skyline_[j].x + skyline_[j].width;
+            if (segRight <= right)
+            {
+                skyline_.erase(skyline_.begin() + j);
+            }
+            else
+            {
+                skyline_[j].width = segRight - right;
+                skyline_[j].x = right;
+                break;
+            }
+        }
+        skyline_.insert(skyline_.begin() + bestSeg, {bestX, right - bestX, bestY + h});
+
+        // merge neighbours at the same level so the skyline stays short
+        for (size_t k = 0; k + 1 < skyline_.size();)
+        {
+            if (skyline_[k].y == skyline_[k + 1].y)
+            {
+                skyline_[k].width += skyline_[k + 1].width;
+                skyline_.erase(skyline_.begin() + k + 1);
+            }
+            else
+            {
+                k++;
+            }
+        }
+    }
+
+    return packHeight;
+}
+
+void SkylinePacker::apply(const Sequence &seq, const std::vector<int> &xs, const std::vector<int> &ys)
+{
+    for (size_t i = 0; i < modules_.size(); i++)
+    {
+        modules_[i]->setRotate(seq.rotated[i]);
+        modules_[i]->setPosition(Point(xs[i], ys[i]));
+    }
+}
+
+Sequence tallestFirst(const SkylinePacker &packer)
+{
+    Sequence seq;
+    int n = packer.size();
+
+    seq.order.resize(n);
+    seq.rotated.assign(n, 0);
+
+    for (int i = 0; i < n; i++)
+    {
+        seq.order[i] = i;
+
+        // rotate so height >= width, unless that no longer fits the outline
+        bool r = packer.getHeight(i, false) < packer.getWidth(i, false);
+        if (packer.getWidth(i, r) > packer.getTargetWidth())
+        {
+            r = !r;
+        }
+        seq.rotated[i] = r;
+    }
+
+    std::stable_sort(seq.order.begin(), seq.order.end(), [&](int a, int b) {
+        return packer.getHeight(a, seq.rotated[a]) > packer.getHeight(b, seq.rotated[b]);
+    });
+
+    return seq;
+}
@@ -2,6 +2,7 @@
 
 void Floorplanner::initialize(std::string inputFile) 
 {
+    ScopedPhase phase("initialize");
     std::cout << "Reading input file: " << inputFile << std::endl;
     std::string word;
     size_t moduleSize;
@@ -19,10 +20,18 @@ void Floorplanner::initialize(std::string inputFile)
         infile >> id >> width >> height;
         modules.push_back(std::unique_ptr<Module>(new Module(id, width, height)));
     }
+
+    // every module is needed for a legal output so the parser always finishes,
+    // the later stages see the expired deadline and take their fast paths
+    if (deadline.expired())
+    {
+        std::cout << "Time budget expired while reading the input" << std::endl;
+    }
 }
 
 void Floorplanner::writeOutput(std::string outputFile) 
 {
+    ScopedPhase phase("writeOutput");
     std::cout << "Writing output file: " << outputFile << std::endl;
     std::ofstream outfile(outputFile);
     for (size_t i = 0; i < modules.size(); i++) 
@@ -34,6 +43,7 @@ void Floorplanner::writeOutput(std::string outputFile)
 
 bool Floorplanner::validityCheck()
 {
+    ScopedPhase phase("validityCheck");
     for (int i = 0 ; i < modules.size(); i++)
     {
         for (int j = i + 1; j < modules.size(); j++)
@@ -0,0 +1,103 @@
+#include "portfolio.h"
+#include <thread>
+
+Portfolio::Portfolio(Floorplanner &base, const std::vector<std::string> &strategies, int goodEnough) : base_(base), goodEnough_(goodEnough)
+{
+    for (auto &s : strategies)
+    {
+        // no portfolios inside portfolios
+        if (s != "portfolio")
+        {
+            strategies_.push_back(s);
+        }
+    }
+}
+
+// called from the worker threads, either for a new incumbent or when a worker is done
+void Portfolio::collect(size_t k, Floorplanner &fp)
+{
+    int height = fp.getHeight();
+    bool optimal = fp.isOptimal();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (bestHeight_ < 0 || height < bestHeight_ || (optimal && !bestOptimal_ && height == bestHeight_))
+    {
+        std::vector<Module *> from = fp.getModules();
+        std::vector<Module *> to = base_.getModules();
+
+        for (size_t i = 0; i < to.size(); i++)
+        {
+            to[i]->setRotate(from[i]->isRotated());
+            to[i]->setPosition(from[i]->getPosition());
+        }
+
+        // the watchdog writes the base incumbent, so it has to follow every improvement
+        base_.saveIncumbent();
+
+        bestHeight_ = height;
+        bestOptimal_ = optimal;
+        bestStrategy_ = strategies_[k];
+        std::cout << "Portfolio: " << bestStrategy_ << " reached height " << height << (optimal ? " (optimal)" : "") << std::endl;
+    }
+
+    if (!done_ && (bestOptimal_ || (goodEnough_ > 0 && bestHeight_ <= goodEnough_)))
+    {
+        done_ = true;
+        std::cout << "Portfolio: stopping the other strategies" << std::endl;
+
+        for (size_t j = 0; j < workers_.size(); j++)
+        {
+            if (j != k)
+            {
+                workers_[j]->cancel();
+            }
+        }
+    }
+}
+
+int Portfolio::run()
+{
+    workers_.clear();
+
+    for (size_t k = 0; k < strategies_.size(); k++)
+    {
+        workers_.push_back(std::make_unique<Floorplanner>());
+        workers_[k]->copyFrom(base_);
+        workers_[k]->setStrategy(strategies_[k]);
+        workers_[k]->setIncumbentCallback([this, k](Floorplanner &fp) { collect(k, fp); });
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < workers_.size(); k++)
+    {
+        threads.emplace_back([this, k]() {
+            setTraceThread("portfolio " + strategies_[k]);
+            Floorplanner &fp = *workers_[k];
+            fp.solve();
+
+            // the final placement can tie the incumbent and still carry the optimality proof
+            if (fp.isLegal())
+            {
+                collect(k, fp);
+            }
+        });
+    }
+
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    if (bestHeight_ >= 0)
+    {
+        std::cout << "Portfolio winner: " << bestStrategy_ << " with height " << bestHeight_ << std::endl;
+    }
+    return bestHeight_;
+}
+
+float Floorplanner::portfolioOpt()
+{
+    Portfolio racer(*this, portfolio, goodEnough);
+    return racer.run();
+}
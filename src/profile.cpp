@@ -0,0 +1,309 @@
+#include "profile.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdlib>
+#include <sys/resource.h>
+
+namespace
+{
+    struct Phase
+    {
+        long calls = 0;
+        double wall = 0.0;      // seconds
+        double cpu = 0.0;       // seconds
+        long allocs = 0;
+        long bytes = 0;
+    };
+
+    // one complete ("X") event, times in ns since the trace started
+    // seq is the claim index + 1 once the event is complete and 0 while it is
+    // written, fields are atomics so a dump racing a writer reads no torn values
+    struct TraceSlot
+    {
+        std::atomic<unsigned long> seq{0};
+        std::atomic<const char *> name{nullptr};
+        std::atomic<long> start{0};
+        std::atomic<long> duration{0};
+        std::atomic<int> tid{0};
+    };
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> traceEnabled{false};
+    std::atomic<long> allocCount{0};
+    std::atomic<long> allocBytes{0};
+
+    std::mutex registryMutex;
+    std::map<std::string, Phase> phases;
+    std::map<std::string, long> counters;
+    std::chrono::steady_clock::time_point profileStart;
+
+    // writers claim slots with one atomic increment, a slot is only rewritten
+    // once the buffer wrapped around, so no lock on the recording path
+    std::vector<TraceSlot> ring;
+    std::atomic<unsigned long> ringHead{0};
+    std::chrono::steady_clock::time_point traceStart;
+
+    std::mutex traceMutex;
+    std::unordered_set<std::string> interned;
+    std::map<std::string, int> trackIds;
+    std::atomic<int> nextTrack{0};
+    thread_local int track = -1;
+
+    int currentTrack()
+    {
+        if (track < 0)
+        {
+            track = nextTrack++;
+        }
+        return track;
+    }
+
+    double threadCpu()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    double processCpu()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    void * allocate(std::size_t size)
+    {
+        if (enabled.load(std::memory_order_relaxed))
+        {
+            allocCount.fetch_add(1, std::memory_order_relaxed);
+            allocBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        void * p = std::malloc(size ? size : 1);
+        if (!p)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+// allocation counting, replaces the global new/delete of the whole program
+void * operator new(std::size_t size) { return allocate(size); }
+void * operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t) noexcept { std::free(p); }
+
+void enableProfile()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    profileStart = std::chrono::steady_clock::now();
+    enabled = true;
+}
+
+bool profiling()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void enableTrace(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    ring = std::vector<TraceSlot>(std::max<size_t>(1, capacity));
+    ringHead = 0;
+    traceStart = std::chrono::steady_clock::now();
+    traceEnabled = true;
+}
+
+bool tracing()
+{
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+void setTraceThread(const std::string &name)
+{
+    if (!tracing())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    auto it = trackIds.find(name);
+    if (it == trackIds.end())
+    {
+        it = trackIds.emplace(name, nextTrack++).first;
+    }
+    track = it->second;
+}
+
+const char * internName(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    return interned.insert(name).first->c_str();
+}
+
+void countEvent(const char * name, long n)
+{
+    if (!profiling())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    counters[name] += n;
+}
+
+void addPhase(const char * name, double wallSeconds)
+{
+    if (!profiling())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Phase &p = phases[name];
+    p.calls++;
+    p.wall += wallSeconds;
+}
+
+ScopedPhase::ScopedPhase(const char * name) : name_(name), active_(profiling()), traced_(tracing())
+{
+    if (active_)
+    {
+        cpu_ = threadCpu();
+        allocs_ = allocCount.load(std::memory_order_relaxed);
+        bytes_ = allocBytes.load(std::memory_order_relaxed);
+    }
+    if (active_ || traced_)
+    {
+        wall_ = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedPhase::~ScopedPhase()
+{
+    if (!active_ && !traced_)
+    {
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (traced_)
+    {
+        unsigned long i = ringHead.fetch_add(1, std::memory_order_relaxed);
+        TraceSlot &slot = ring[i % ring.size()];
+
+        // busy first, a dump that sees any of the new fields then sees the slot busy too
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name_, std::memory_order_relaxed);
+        slot.start.store(std::chrono::duration_cast<std::chrono::nanoseconds>(wall_ - traceStart).count(), std::memory_order_relaxed);
+        slot.duration.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - wall_).count(), std::memory_order_relaxed);
+        slot.tid.store(currentTrack(), std::memory_order_relaxed);
+        slot.seq.store(i + 1, std::memory_order_release);
+    }
+
+    if (!active_)
+    {
+        return;
+    }
+
+    double wall = std::chrono::duration<double>(end - wall_).count();
+    double cpu = threadCpu() - cpu_;
+    long allocs = allocCount.load(std::memory_order_relaxed) - allocs_;
+    long bytes = allocBytes.load(std::memory_order_relaxed) - bytes_;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    Phase &p = phases[name_];
+    p.calls++;
+    p.wall += wall;
+    p.cpu += cpu;
+    p.allocs += allocs;
+    p.bytes += bytes;
+}
+
+void writeProfile(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - profileStart).count();
+
+    out << "{\n";
+    out << "  \"wall_ms\": " << 1e3 * wall << ",\n";
+    out << "  \"cpu_ms\": " << 1e3 * processCpu() << ",\n";
+    out << "  \"peak_rss_kb\": " << usage.ru_maxrss << ",\n";
+    out << "  \"allocs\": " << allocCount.load() << ",\n";
+    out << "  \"alloc_bytes\": " << allocBytes.load() << ",\n";
+
+    out << "  \"phases\": {";
+    bool first = true;
+    for (auto &[name, p] : phases)
+    {
+        out << (first ? "\n" : ",\n");
+        out << "    \"" << name << "\": {\"calls\": " << p.calls << ", \"wall_ms\": " << 1e3 * p.wall << ", \"cpu_ms\": " << 1e3 * p.cpu
+            << ", \"allocs\": " << p.allocs << ", \"alloc_bytes\": " << p.bytes << "}";
+        first = false;
+    }
+    out << "\n  },\n";
+
+    out << "  \"counters\": {";
+    first = true;
+    for (auto &[name, n] : counters)
+    {
+        out << (first ? "\n" : ",\n");
+        out << "    \"" << name << "\": " << n;
+        first = false;
+    }
+    out << "\n  }\n";
+    out << "}\n";
+}
+
+void writeTrace(std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+
+    unsigned long head = ringHead.load();
+    unsigned long first = head > ring.size() ? head - ring.size() : 0;
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"fp\"}}";
+
+    for (auto &[name, tid] : trackIds)
+    {
+        out << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid << ", \"args\": {\"name\": \"" << name << "\"}}";
+    }
+
+    // other threads keep recording during the dump, an event is only written if its
+    // slot held the same complete event before and after the fields were read
+    for (unsigned long i = first; i < head; i++)
+    {
+        const TraceSlot &slot = ring[i % ring.size()];
+        unsigned long seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != i + 1)
+        {
+            continue;
+        }
+
+        const char * name = slot.name.load(std::memory_order_relaxed);
+        long start = slot.start.load(std::memory_order_relaxed);
+        long duration = slot.duration.load(std::memory_order_relaxed);
+        int tid = slot.tid.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!name || slot.seq.load(std::memory_order_relaxed) != seq)
+        {
+            continue;
+        }
+
+        out << ",\n  {\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+            << ", \"ts\": " << start / 1000.0 << ", \"dur\": " << duration / 1000.0 << "}";
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,117 @@
+#include "floorplanner.h"
+
+// repair heuristic for the node callback of solveCluster
+// the node relaxation is rarely a floorplan, but its y (then x) order and its
+// rotation flags say where the search is heading. The skyline packer decodes that
+// order into a legal floorplan and compaction tightens it, only floorplans strictly
+// lower than the incumbent are offered back to Gurobi
+// it runs inside optimize(), so it works on scratch copies of the modules and the
+// cluster's own outline, the real modules only move once the solve is over
+Solver::Assignment Floorplanner::repairNode(const std::vector<Module *> &list, const std::vector<ModuleVars> &vars, float targetWidth, float targetHeight, const std::function<double(const std::string &)> &relaxed, double best)
+{
+    if (deadline.expired())
+    {
+        return {};
+    }
+
+    int n = list.size();
+    std::vector<std::unique_ptr<Module>> scratch;
+    std::vector<Module *> copies;
+    for (auto m : list)
+    {
+        scratch.push_back(std::unique_ptr<Module>(new Module(m->getId(), m->getOrgWidth(), m->getOrgHeight())));
+        copies.push_back(scratch.back().get());
+    }
+    SkylinePacker packer(copies, targetWidth);
+
+    Sequence seq;
+    seq.order.resize(n);
+    seq.rotated.resize(n);
+
+    std::vector<double> rx(n), ry(n);
+    for (int i = 0; i < n; i++)
+    {
+        rx[i] = relaxed(vars[i].x);
+        ry[i] = relaxed(vars[i].y);
+        seq.order[i] = i;
+        seq.rotated[i] = relaxed(vars[i].r) > 0.5 && packer.getWidth(i, true) <= targetWidth;
+    }
+    std::sort(seq.order.begin(), seq.order.end(), [&](int a, int b) {
+        return ry[a] != ry[b] ? ry[a] < ry[b] : rx[a] < rx[b];
+    });
+
+    std::vector<int> xs, ys;
+    packer.pack(seq, xs, ys);
+    packer.apply(seq, xs, ys);
+    int height = Compactor(copies).compact(deadline, 4);
+
+    if (height > targetHeight || height >= best - 0.5)
+    {
+        return {};
+    }
+
+    std::vector<Obstacle> rects(n);
+    for (int i = 0; i < n; i++)
+    {
+        Module * m = copies[i];
+        rects[i] = {m->getPosition().x(), m->getPosition().y(), double(m->getRotatedWidth()), double(m->getRotatedHeight())};
+        if (rects[i].x + rects[i].w > targetWidth)
+        {
+            return {};
+        }
+    }
+
+    Solver::Assignment solution;
+    solution.reserve(3 * n + 1 + n * (n - 1));
+    solution.push_back({"Y", double(height)});
+
+    // only reads variable names, the big-M is not needed
+    Formulation formulation(solver(), 0.0, encoding);
+
+    for (int i = 0; i < n; i++)
+    {
+        solution.push_back({vars[i].x, rects[i].x});
+        solution.push_back({vars[i].y, rects[i].y});
+        solution.push_back({vars[i].r, copies[i]->isRotated() ? 1.0 : 0.0});
+
+        for (int j = i + 1; j < n; j++)
+        {
+            for (auto &v : formulation.pairValues(std::to_string(i) + "_" + std::to_string(j), relation(rects[i], rects[j])))
+            {
+                solution.push_back(v);
+            }
+        }
+    }
+
+    std::cout << "Node repair: height " << height << std::endl;
+
+    // the repaired floorplan of the whole instance also backs up the budget watchdog,
+    // it goes straight into the incumbent since the modules themselves stay put, the
+    // incumbent callback waits for the solve to end and the placement to be applied
+    if (list.size() == modules.size() && targetWidth >= spec.targetWidth && height <= spec.targetHeight)
+    {
+        std::unordered_map<const Module *, int> slot;
+        for (int i = 0; i < n; i++)
+        {
+            slot[list[i]] = i;
+        }
+
+        std::lock_guard<std::mutex> lock(incumbentMutex);
+        if (incumbent.height < 0 || height < incumbent.height)
+        {
+            incumbent.x.resize(n);
+            incumbent.y.resize(n);
+            incumbent.rotated.resize(n);
+            for (int k = 0; k < n; k++)
+            {
+                int i = slot[modules[k].get()];
+                incumbent.x[k] = std::lround(rects[i].x);
+                incumbent.y[k] = std::lround(rects[i].y);
+                incumbent.rotated[k] = copies[i]->isRotated();
+            }
+            incumbent.height = height;
+        }
+    }
+
+    return solution;
+}
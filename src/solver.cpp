@@ -1,30 +1,91 @@
 #include "solver.h"
 
-Solver::Solver() : env_(std::make_unique<GRBEnv>(true)), model_(nullptr), status_(GRB_LOADED) 
+// one callback per solver for everything that has to run inside optimize():
+// telemetry at MIP / MIPSOL and the node heuristic at MIPNODE
+class Solver::Callback : public GRBCallback
 {
-    try 
+public:
+    Callback(Solver &solver) : solver_(solver) {}
+
+    NodeHeuristic heuristic;
+    int interval = 1;
+    double next = 0.0;
+
+    double presolved = 0.0;     // runtime at the last presolve callback
+
+    double lastTime = -1.0;
+    double lastObj = GRB_INFINITY;
+    double lastBound = -GRB_INFINITY;
+
+protected:
+    void callback() override
     {
-        std::cout << "Initializing Gurobi model...\n";
-    
-        if (!std::getenv("GRB_LICENSE_FILE") && std::filesystem::exists("./gurobi.lic")) 
+        try
         {
-            setenv("GRB_LICENSE_FILE", "./gurobi.lic", 1);
-        }
+            if (where == GRB_CB_PRESOLVE)
+            {
+                presolved = getDoubleInfo(GRB_CB_RUNTIME);
+            }
+            else if (where == GRB_CB_MIP && solver_.recording_)
+            {
+                // periodic progress, only kept when something moved or once a second
+                double obj = getDoubleInfo(GRB_CB_MIP_OBJBST);
+                double bound = getDoubleInfo(GRB_CB_MIP_OBJBND);
+                double now = solver_.clock();
+                if (obj != lastObj || bound != lastBound || now - lastTime >= 1.0)
+                {
+                    solver_.record("progress", obj, bound, getDoubleInfo(GRB_CB_MIP_NODCNT), getDoubleInfo(GRB_CB_WORK));
+                    lastTime = now;
+                    lastObj = obj;
+                    lastBound = bound;
+                }
+            }
+            else if (where == GRB_CB_MIPSOL && solver_.recording_)
+            {
+                solver_.record("incumbent", getDoubleInfo(GRB_CB_MIPSOL_OBJ), getDoubleInfo(GRB_CB_MIPSOL_OBJBND),
+                    getDoubleInfo(GRB_CB_MIPSOL_NODCNT), getDoubleInfo(GRB_CB_WORK));
+            }
+            else if (where == GRB_CB_MIPNODE && heuristic && getIntInfo(GRB_CB_MIPNODE_STATUS) == GRB_OPTIMAL)
+            {
+                double nodes = getDoubleInfo(GRB_CB_MIPNODE_NODCNT);
+                if (nodes < next)
+                {
+                    return;
+                }
+                next = nodes + interval;
 
-        env_->set("LogToConsole", "1");
-        env_->set("LogFile", "gurobi.log"); 
-        env_->start();                      
+                auto relaxed = [&](const std::string &name) { return getNodeRel(solver_.var(name)); };
+                Assignment solution = heuristic(relaxed, getDoubleInfo(GRB_CB_MIPNODE_OBJBST));
+                if (solution.empty())
+                {
+                    return;
+                }
 
-        model_ = std::make_unique<GRBModel>(*env_);
-        std::cout << "Gurobi model initialized.\n";
-    }
-    catch (const GRBException& e) 
-    {
-        std::cerr << "[Gurobi Init Failed] code=" << e.getErrorCode() << " msg=" << e.getMessage() << "\n";
-        throw; 
+                for (const auto& [name, value] : solution)
+                {
+                    setSolution(solver_.var(name), value);
+                }
+                useSolution();
+            }
+        }
+        catch (const GRBException& e)
+        {
+            std::cerr << "[Callback failed] code=" << e.getErrorCode() << " msg=" << e.getMessage() << "\n";
+        }
     }
+
+private:
+    Solver &solver_;
+};
+
+// nothing touches Gurobi until the first model is built, runs that never get to
+// an ILP need no license and print no banner
+Solver::Solver() : status_(GRB_LOADED), callback_(std::make_unique<Callback>(*this)), start_(std::chrono::steady_clock::now())
+{
 }
 
+Solver::~Solver() = default;
+
 int Solver::objSense(std::string s)
 {
     if (s == "MIN") 
@@ -49,7 +110,7 @@ void Solver::addVariable(const std::string &name, double lb, double ub, char typ
         throw std::runtime_error("Variable already exists: " + name);
     }
 
-    GRBVar v = model_->addVar(lb, ub, 0.0, type, name);
+    GRBVar v = model().addVar(lb, ub, 0.0, type, name);
     varmap_.emplace(name, v);
 }
 
@@ -65,7 +126,31 @@ void Solver::addConstraint(const std::string &name, const std::vector<std::pair<
         }
         expr += coef * it->second;
     }
-    model_->addConstr(expr, sense, rhs, name);
+    constrmap_[name] = model().addConstr(expr, sense, rhs, name);
+    tally_.rows[family(name)]++;
+}
+
+void Solver::addIndicator(const std::string &name, const std::string &flag, int value, const std::vector<std::pair<std::string, double>> &vars, char sense, double rhs)
+{
+    GRBLinExpr expr = 0.0;
+    for (const auto& [vname, coef] : vars) 
+    {
+        auto it = varmap_.find(vname);
+        if (it == varmap_.end())
+        {
+            throw std::runtime_error("Unknown variable in indicator '" + name + "': " + vname);
+        }
+        expr += coef * it->second;
+    }
+    model().addGenConstrIndicator(var(flag), value, expr, sense, rhs, name);
+
+    tally_.indicators[family(name)]++;
+    tally_.nonzeros += vars.size();
+    for (const auto& [vname, coef] : vars)
+    {
+        widen(coef, tally_.coefMin, tally_.coefMax);
+    }
+    widen(rhs, tally_.rhsMin, tally_.rhsMax);
 }
 
 void Solver::setObjective(const std::vector<std::pair<std::string, double>> &vars, char sense) 
@@ -80,26 +165,204 @@ void Solver::setObjective(const std::vector<std::pair<std::string, double>> &var
         }
         expr += coef * it->second;
     }
-    model_->setObjective(expr, sense);
+    model().setObjective(expr, sense);
 }
 
 void Solver::optimize() 
 {
-    model_->optimize();
-    status_ = model_->get(GRB_IntAttr_Status);
+    if (terminated_)
+    {
+        // no time left, same as hitting the limit before the first node
+        model().set(GRB_DoubleParam_TimeLimit, 0.0);
+    }
+
+    ScopedPhase phase("optimize");
+
+    solves_++;
+    callback_->next = 0.0;
+    callback_->presolved = 0.0;
+    callback_->lastTime = -1.0;
+    callback_->lastObj = GRB_INFINITY;
+    callback_->lastBound = -GRB_INFINITY;
+    if (recording_)
+    {
+        record("start", GRB_INFINITY, -GRB_INFINITY, 0.0, 0.0);
+    }
+
+    model().optimize();
+    status_ = model().get(GRB_IntAttr_Status);
+    addPhase("presolve", callback_->presolved);
+
+    if (recording_)
+    {
+        // bound and objective do not exist for every status, e.g. infeasible or no solution
+        double obj = getSolutionCount() > 0 ? model().get(GRB_DoubleAttr_ObjVal) : GRB_INFINITY;
+        double bound = -GRB_INFINITY;
+        double nodes = 0.0;
+        try
+        {
+            bound = model().get(GRB_DoubleAttr_ObjBound);
+            nodes = model().get(GRB_DoubleAttr_NodeCount);
+        }
+        catch (const GRBException &)
+        {
+        }
+        record("done", obj, bound, nodes, model().get(GRB_DoubleAttr_Work));
+    }
+}
+
+double Solver::clock() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+// solvers of parallel workers may share one telemetry sink, only whole lines go out
+static void writeLine(std::ostream &sink, const std::string &line)
+{
+    static std::mutex sinkMutex;
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sink << line << std::flush;
+}
+
+// JSON has no infinity, an objective or bound that does not exist yet is null
+static void writeNumber(std::ostream &out, double v)
+{
+    if (std::isfinite(v) && std::abs(v) < GRB_INFINITY)
+    {
+        out << v;
+    }
+    else
+    {
+        out << "null";
+    }
+}
+
+void Solver::record(const char * event, double objective, double bound, double nodes, double work)
+{
+    Progress p;
+    p.time = clock();
+    p.solve = solves_;
+    p.event = event;
+    p.objective = objective;
+    p.bound = bound;
+    p.nodes = nodes;
+    p.work = work;
+
+    // same definition as Gurobi's MIPGap
+    bool known = std::abs(objective) < GRB_INFINITY && std::abs(bound) < GRB_INFINITY;
+    p.gap = !known ? GRB_INFINITY : objective == 0.0 ? (bound == 0.0 ? 0.0 : GRB_INFINITY) : std::abs(objective - bound) / std::abs(objective);
+
+    timeline_.push_back(p);
+
+    if (sink_)
+    {
+        std::ostringstream line;
+        line << "{\"t\":" << p.time << ",\"solve\":" << p.solve << ",\"event\":\"" << p.event << "\",\"obj\":";
+        writeNumber(line, p.objective);
+        line << ",\"bound\":";
+        writeNumber(line, p.bound);
+        line << ",\"gap\":";
+        writeNumber(line, p.gap);
+        line << ",\"nodes\":" << p.nodes << ",\"work\":" << p.work << "}\n";
+
+        writeLine(*sink_, line.str());
+    }
+}
+
+void Solver::setTelemetry(bool record, std::ostream *sink)
+{
+    recording_ = record;
+    sink_ = record ? sink : nullptr;
+}
+
+void Solver::setLogging(const std::string &logFile, bool console)
+{
+    logFile_ = logFile;
+    console_ = console;
+
+    // the env is what new models are made from, the current model has its own copy
+    if (env_)
+    {
+        env_->set(GRB_StringParam_LogFile, logFile);
+        env_->set(GRB_IntParam_LogToConsole, console ? 1 : 0);
+    }
+    if (model_)
+    {
+        model_->set(GRB_StringParam_LogFile, logFile);
+        model_->set(GRB_IntParam_LogToConsole, console ? 1 : 0);
+    }
+}
+
+// the model, made on first use from the env, which is started the first time
+// with the log settings known by then
+GRBModel &Solver::model()
+{
+    if (model_)
+    {
+        return *model_;
+    }
+
+    std::lock_guard<std::mutex> lock(modelMutex_);
+    try
+    {
+        if (!env_)
+        {
+            std::cout << "Initializing Gurobi model...\n";
+
+            if (!std::getenv("GRB_LICENSE_FILE") && std::filesystem::exists("./gurobi.lic"))
+            {
+                setenv("GRB_LICENSE_FILE", "./gurobi.lic", 1);
+            }
+
+            env_ = std::make_unique<GRBEnv>(true);
+            env_->set(GRB_IntParam_LogToConsole, console_ ? 1 : 0);
+            env_->set(GRB_StringParam_LogFile, logFile_);
+            env_->start();
+            std::cout << "Gurobi model initialized.\n";
+        }
+
+        model_ = std::make_unique<GRBModel>(*env_);
+        model_->setCallback(callback_.get());
+    }
+    catch (const GRBException& e)
+    {
+        std::cerr << "[Gurobi Init Failed] code=" << e.getErrorCode() << " msg=" << e.getMessage() << "\n";
+        throw;
+    }
+    return *model_;
 }
 
 void Solver::reset() 
 {
     std::cout << "Resetting the solver..." << std::endl;
 
+    // the next model() makes a fresh one
+    std::lock_guard<std::mutex> lock(modelMutex_);
     model_.reset();                               
-    varmap_.clear();                              
-    model_ = std::make_unique<GRBModel>(*env_);   
+    varmap_.clear();
+    constrmap_.clear();                              
+    callback_->heuristic = nullptr;
+    tally_ = ModelStats();
 
     status_ = GRB_LOADED;
 }
 
+void Solver::terminate()
+{
+    std::lock_guard<std::mutex> lock(modelMutex_);
+    terminated_ = true;
+    if (model_)
+    {
+        model_->terminate();
+    }
+}
+
+void Solver::setNodeHeuristic(NodeHeuristic heuristic, int interval)
+{
+    callback_->heuristic = heuristic;
+    callback_->interval = std::max(1, interval);
+}
+
 double Solver::getObjectiveValue() const 
 {
     return model_->get(GRB_DoubleAttr_ObjVal);
@@ -107,11 +370,90 @@ double Solver::getObjectiveValue() const
 
 void Solver::setTimeLimit(double seconds) 
 {
-    if (!model_) 
+    model().set(GRB_DoubleParam_TimeLimit, seconds);
+}
+
+void Solver::setBestObjStop(double value)
+{
+    model().set(GRB_DoubleParam_BestObjStop, value);
+}
+
+void Solver::setCutoff(double value)
+{
+    model().set(GRB_DoubleParam_Cutoff, value);
+}
+
+void Solver::setSolutionLimit(int count)
+{
+    model().set(GRB_IntParam_SolutionLimit, count);
+}
+
+void Solver::setBranchPriority(const std::string &name, int priority)
+{
+    var(name).set(GRB_IntAttr_BranchPriority, priority);
+}
+
+void Solver::setHint(const std::string &name, double value, int priority)
+{
+    GRBVar &v = var(name);
+    v.set(GRB_DoubleAttr_VarHintVal, value);
+    v.set(GRB_IntAttr_VarHintPri, priority);
+}
+
+GRBVar &Solver::var(const std::string &name)
+{
+    auto it = varmap_.find(name);
+    if (it == varmap_.end())
     {
-        return;
+        throw std::runtime_error("Unknown variable: " + name);
     }
-    model_->set(GRB_DoubleParam_TimeLimit, seconds);
+    return it->second;
+}
+
+GRBConstr &Solver::constr(const std::string &name)
+{
+    auto it = constrmap_.find(name);
+    if (it == constrmap_.end())
+    {
+        throw std::runtime_error("Unknown constraint: " + name);
+    }
+    return it->second;
+}
+
+void Solver::setUpperBound(const std::string &name, double ub)
+{
+    var(name).set(GRB_DoubleAttr_UB, ub);
+}
+
+void Solver::setLowerBound(const std::string &name, double lb)
+{
+    var(name).set(GRB_DoubleAttr_LB, lb);
+}
+
+void Solver::setRHS(const std::string &constraint, double rhs)
+{
+    constr(constraint).set(GRB_DoubleAttr_RHS, rhs);
+}
+
+void Solver::setCoefficient(const std::string &constraint, const std::string &name, double coef)
+{
+    model().chgCoeff(constr(constraint), var(name), coef);
+}
+
+void Solver::setObjectiveCoefficient(const std::string &name, double coef)
+{
+    var(name).set(GRB_DoubleAttr_Obj, coef);
+}
+
+// MIP start value, Gurobi completes the variables that are left out
+void Solver::setStart(const std::string &name, double value)
+{
+    auto it = varmap_.find(name);
+    if (it == varmap_.end())
+    {
+        throw std::runtime_error("Unknown variable: " + name);
+    }
+    it->second.set(GRB_DoubleAttr_Start, value);
 }
 
 double Solver::getVariableValue(const std::string &name) const 
@@ -128,4 +470,118 @@ int Solver::getSolutionCount()
 {
     if (!model_) return 0;
     return model_->get(GRB_IntAttr_SolCount);
-}
\ No newline at end of file
+}
+
+// "left_3_17" -> "left", "inside_outline_x12" -> "inside_outline_x"
+std::string Solver::family(const std::string &name)
+{
+    size_t end = name.find_first_of("0123456789");
+    std::string f = name.substr(0, end);
+    while (!f.empty() && f.back() == '_')
+    {
+        f.pop_back();
+    }
+    return f;
+}
+
+// track the range of the nonzero magnitudes
+void Solver::widen(double v, double &lo, double &hi)
+{
+    v = std::abs(v);
+    if (v == 0.0 || v >= GRB_INFINITY)
+    {
+        return;
+    }
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+}
+
+// Gurobi's ranges only cover the linear rows, the indicator ones come from the tally
+Solver::ModelStats Solver::getModelStats()
+{
+    GRBModel &m = model();
+    m.update();
+
+    ModelStats stats = tally_;
+
+    int vars = m.get(GRB_IntAttr_NumVars);
+    int integers = m.get(GRB_IntAttr_NumIntVars);   // binaries included
+    stats.binary = m.get(GRB_IntAttr_NumBinVars);
+    stats.integer = integers - stats.binary;
+    stats.continuous = vars - integers;
+    stats.nonzeros += m.get(GRB_IntAttr_NumNZs);
+
+    if (m.get(GRB_IntAttr_NumConstrs) > 0)
+    {
+        widen(m.get(GRB_DoubleAttr_MinCoeff), stats.coefMin, stats.coefMax);
+        widen(m.get(GRB_DoubleAttr_MaxCoeff), stats.coefMin, stats.coefMax);
+        widen(m.get(GRB_DoubleAttr_MinRHS), stats.rhsMin, stats.rhsMax);
+        widen(m.get(GRB_DoubleAttr_MaxRHS), stats.rhsMin, stats.rhsMax);
+    }
+    if (vars > 0)
+    {
+        widen(m.get(GRB_DoubleAttr_MinBound), stats.boundMin, stats.boundMax);
+        widen(m.get(GRB_DoubleAttr_MaxBound), stats.boundMin, stats.boundMax);
+    }
+
+    return stats;
+}
+
+void Solver::reportModel(double buildMs)
+{
+    if (!console_ && !sink_)
+    {
+        return;
+    }
+
+    ModelStats stats = getModelStats();
+
+    auto range = [](double lo, double hi) {
+        std::ostringstream r;
+        r << "[" << (hi > 0.0 ? lo : 0.0) << ", " << hi << "]";
+        return r.str();
+    };
+
+    if (console_)
+    {
+        std::cout << "Model: " << stats.continuous << " continuous, " << stats.binary << " binary, " << stats.integer << " integer variables, "
+                  << stats.nonzeros << " nonzeros, built in " << buildMs << " ms" << std::endl;
+        std::cout << "  rows:";
+        for (auto &[f, n] : stats.rows)
+        {
+            std::cout << " " << f << " " << n;
+        }
+        for (auto &[f, n] : stats.indicators)
+        {
+            std::cout << " " << f << "(indicator) " << n;
+        }
+        std::cout << std::endl;
+        std::cout << "  |coef| " << range(stats.coefMin, stats.coefMax) << ", |rhs| " << range(stats.rhsMin, stats.rhsMax)
+                  << ", |bound| " << range(stats.boundMin, stats.boundMax) << std::endl;
+    }
+
+    if (sink_)
+    {
+        std::ostringstream line;
+        line << "{\"t\":" << clock() << ",\"solve\":" << solves_ + 1 << ",\"event\":\"model\",\"build_ms\":" << buildMs
+             << ",\"continuous\":" << stats.continuous << ",\"binary\":" << stats.binary << ",\"integer\":" << stats.integer
+             << ",\"nonzeros\":" << stats.nonzeros << ",\"rows\":{";
+        bool first = true;
+        for (auto &[f, n] : stats.rows)
+        {
+            line << (first ? "" : ",") << "\"" << f << "\":" << n;
+            first = false;
+        }
+        line << "},\"indicators\":{";
+        first = true;
+        for (auto &[f, n] : stats.indicators)
+        {
+            line << (first ? "" : ",") << "\"" << f << "\":" << n;
+            first = false;
+        }
+        line << "},\"coef\":[" << (stats.coefMax > 0.0 ? stats.coefMin : 0.0) << "," << stats.coefMax << "]"
+             << ",\"rhs\":[" << (stats.rhsMax > 0.0 ? stats.rhsMin : 0.0) << "," << stats.rhsMax << "]}\n";
+
+        writeLine(*sink_, line.str());
+    }
+}
@@ -0,0 +1,254 @@
+#include "tempering.h"
+#include "profile.h"
+#include <chrono>
+#include <thread>
+
+Tempering::Tempering(const SkylinePacker &packer, const Sequence &initial) : initial_(initial), best_(initial)
+{
+    replicas_.emplace_back(packer);
+}
+
+// height first, then how low the modules sit on average
+// the second term is below 1 so it only breaks ties between equal heights
+// and gives the walk a slope on the plateaus that pure height has
+double Tempering::evaluate(Replica &rep, const Sequence &seq, int &height)
+{
+    height = rep.packer.pack(seq, rep.xs, rep.ys);
+
+    if (height == 0)
+    {
+        return 0.0;
+    }
+
+    double top = 0.0;
+    for (int i = 0; i < rep.packer.size(); i++)
+    {
+        top += rep.ys[i] + rep.packer.getHeight(i, seq.rotated[i]);
+    }
+
+    return height + top / (double(rep.packer.size()) * height);
+}
+
+void Tempering::mutate(Replica &rep)
+{
+    rep.trial = rep.seq;
+
+    int n = rep.trial.order.size();
+    if (n < 2)
+    {
+        return;
+    }
+
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    int a = pick(rep.rng);
+    int b = pick(rep.rng);
+
+    switch (std::uniform_int_distribution<int>(0, 2)(rep.rng))
+    {
+        case 0:
+        {
+            // rotate one module, only if it still fits the outline afterwards
+            int m = rep.trial.order[a];
+            if (rep.packer.getWidth(m, !rep.trial.rotated[m]) <= rep.packer.getTargetWidth())
+            {
+                rep.trial.rotated[m] = !rep.trial.rotated[m];
+                break;
+            }
+            std::swap(rep.trial.order[a], rep.trial.order[b]);
+            break;
+        }
+        case 1:
+        {
+            // swap two modules in the packing order
+            std::swap(rep.trial.order[a], rep.trial.order[b]);
+            break;
+        }
+        default:
+        {
+            // move one module to another place in the order
+            int m = rep.trial.order[a];
+            rep.trial.order.erase(rep.trial.order.begin() + a);
+            rep.trial.order.insert(rep.trial.order.begin() + b, m);
+            break;
+        }
+    }
+}
+
+void Tempering::sweep(Replica &rep, int moves)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    for (int k = 0; k < moves; k++)
+    {
+        mutate(rep);
+
+        int height;
+        double cost = evaluate(rep, rep.trial, height);
+        double delta = cost - rep.cost;
+
+        rep.proposed++;
+
+        if (delta <= 0.0 || uniform(rep.rng) < std::exp(-delta / rep.temperature))
+        {
+            std::swap(rep.seq, rep.trial);
+            rep.cost = cost;
+            rep.height = height;
+            rep.accepted++;
+
+            if (cost < rep.bestCost)
+            {
+                rep.best = rep.seq;
+                rep.bestCost = cost;
+            }
+        }
+    }
+}
+
+int Tempering::run(const TemperingOptions &opt, const Deadline &deadline)
+{
+    using clock = std::chrono::steady_clock;
+
+    int R = std::max(1, opt.replicas);
+    SkylinePacker packer = replicas_[0].packer;
+
+    replicas_.clear();
+    replicas_.reserve(R);
+    cooling_ = opt.cooling;
+
+    for (int k = 0; k < R; k++)
+    {
+        replicas_.emplace_back(packer);
+        Replica &rep = replicas_.back();
+
+        rep.rng.seed(opt.seed + 7919u * k);
+        rep.seq = initial_;
+        rep.best = initial_;
+        rep.cost = evaluate(rep, rep.seq, rep.height);
+        rep.bestCost = rep.cost;
+    }
+
+    // temperature ladder, geometric between the two ends
+    // a few percent of the starting height is hot enough to accept most uphill moves
+    double start = std::max(1, replicas_[0].height);
+    double tMax = opt.tMax > 0.0 ? opt.tMax : std::max(1.0, 0.02 * start);
+    double tMin = opt.tMin > 0.0 ? opt.tMin : std::max(0.05, 0.001 * start);
+
+    for (int k = 0; k < R; k++)
+    {
+        double f = R == 1 ? 0.0 : double(k) / (R - 1);
+        replicas_[k].temperature = tMin * std::pow(tMax / tMin, f);
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::mt19937 swapRng(opt.seed);
+    auto begin = clock::now();
+    int parity = 0;
+
+    while (true)
+    {
+        double elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+        if (elapsed >= opt.timeLimit || deadline.expired())
+        {
+            break;
+        }
+
+        // single chain annealing walks from hot to cold over the time budget
+        if (cooling_)
+        {
+            for (auto &rep : replicas_)
+            {
+                rep.temperature = tMax * std::pow(tMin / tMax, elapsed / opt.timeLimit);
+            }
+        }
+
+        std::vector<std::thread> workers;
+        for (int k = 1; k < R; k++)
+        {
+            workers.emplace_back([this, k, &opt]() {
+                // every round starts new threads, keep each replica on one trace track
+                setTraceThread("replica " + std::to_string(k));
+                ScopedPhase phase("tempering.sweep");
+                sweep(replicas_[k], opt.swapInterval);
+            });
+        }
+        {
+            ScopedPhase phase("tempering.sweep");
+            sweep(replicas_[0], opt.swapInterval);
+        }
+
+        for (auto &t : workers)
+        {
+            t.join();
+        }
+
+        if (cooling_)
+        {
+            continue;
+        }
+
+        // exchange states between neighbouring temperatures
+        // alternate even and odd pairs so every neighbour pair gets a turn
+        for (int k = parity; k + 1 < R; k += 2)
+        {
+            Replica &cold = replicas_[k];
+            Replica &hot = replicas_[k + 1];
+            double exponent = (1.0 / cold.temperature - 1.0 / hot.temperature) * (cold.cost - hot.cost);
+
+            cold.swapsProposed++;
+            hot.swapsProposed++;
+
+            if (exponent >= 0.0 || uniform(swapRng) < std::exp(exponent))
+            {
+                std::swap(cold.seq, hot.seq);
+                std::swap(cold.cost, hot.cost);
+                std::swap(cold.height, hot.height);
+                cold.swapsAccepted++;
+                hot.swapsAccepted++;
+
+                if (cold.cost < cold.bestCost)
+                {
+                    cold.best = cold.seq;
+                    cold.bestCost = cold.cost;
+                }
+            }
+        }
+        parity ^= 1;
+    }
+
+    // pick the best state any replica has seen
+    double bestCost = std::numeric_limits<double>::infinity();
+    for (auto &rep : replicas_)
+    {
+        int height;
+        double cost = evaluate(rep, rep.best, height);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestHeight_ = height;
+            best_ = rep.best;
+        }
+    }
+
+    return bestHeight_;
+}
+
+void Tempering::report() const
+{
+    for (size_t k = 0; k < replicas_.size(); k++)
+    {
+        const Replica &rep = replicas_[k];
+        double acceptance = rep.proposed ? double(rep.accepted) / rep.proposed : 0.0;
+
+        std::cout << "replica " << k << ": T=" << rep.temperature
+                  << " moves=" << rep.proposed
+                  << " acceptance=" << acceptance;
+
+        if (!cooling_ && replicas_.size() > 1)
+        {
+            double swaps = rep.swapsProposed ? double(rep.swapsAccepted) / rep.swapsProposed : 0.0;
+            std::cout << " swap acceptance=" << swaps;
+        }
+
+        std::cout << " best height=" << int(rep.bestCost) << std::endl;
+    }
+}